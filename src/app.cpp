@@ -2,12 +2,14 @@
 #include "json_loader.h"
 #include "postgres.h"
 
+#include <algorithm>
+
 namespace app {
 
 using namespace std::literals;
 
-const model::PlayerPtr& Players::Add(const model::DogPtr& dog, const model::GameSessionPtr& session) {
-    return players_.emplace(dog->GetId(), std::make_shared<model::Player>(session, dog)).first->second;
+const model::PlayerPtr& Players::Add(size_t dog_id, const model::GameSessionPtr& session) {
+    return players_.emplace(dog_id, std::make_shared<model::Player>(session, dog_id)).first->second;
 }
 
 std::optional<std::reference_wrapper<const model::PlayerPtr>> Players::FindPlayerById(size_t id) const {
@@ -21,7 +23,7 @@ bool Players::RemovePlayer(size_t id) {
     return players_.erase(id) != 0;
 }
 
-std::optional<std::reference_wrapper<const model::PlayerPtr>> PlayerTokens::FindPlayerByToken(const model::Token& token) const noexcept {
+std::optional<std::reference_wrapper<const model::PlayerPtr>> PlayerTokens::FindPlayerByToken(std::string_view token) const noexcept {
     if (auto it = token_to_player_.find(token); it != token_to_player_.end()) {
         return std::ref(it->second);
     }
@@ -74,111 +76,76 @@ std::pair<const model::PlayerPtr&, model::Token> Application::JoinGame(const mod
 
     geom::Point2D pos;
     if(random_spawns_) { //select randowm starting location
-        std::uniform_int_distribution<int> uni(0,map->GetRoads().size()-1);
-        const auto& road = map->GetRoads()[uni(rand_)];
-        if(road->IsHorizontal()) {
-            std::uniform_real_distribution<double> uni2(road->GetStart().x, road->GetEnd().x);
-            pos.x = uni2(rand_);
-            pos.y = road->GetStart().y;
-        } else {
-            std::uniform_real_distribution<double> uni2(road->GetStart().y, road->GetEnd().y);
-            pos.y = uni2(rand_);
-            pos.x = road->GetStart().x;
-        }
+        pos = GetRandomPointOnMap(map, session->GetRandom());
     } else {
-        auto start = map->GetRoads().front()->GetStart();
+        auto start = map->GetRoads().front().GetStart();
         pos = {static_cast<double>(start.x), static_cast<double>(start.y)};
     }
+    //случайная точка в режиме фиксированной точки сразу ставится на сетку, иначе её округлит первый тик
+    if(fixed_point_movement_) {
+        pos = geom::SnapToFixed(pos);
+    }
 
-    auto& dog = session->CreateDog(user_name, pos);
-    auto& player = players_.Add(dog, session);
+    auto dog = session->CreateDog(user_name, pos);
+    auto& player = players_.Add(dog.GetId(), session);
     auto token = tokens_.AddPlayer(player);
     return {player, std::move(token)};
 }
 
-std::optional<std::reference_wrapper<const model::PlayerPtr>> Application::FindPlayerByToken(const model::Token& token) {
+std::optional<std::reference_wrapper<const model::PlayerPtr>> Application::FindPlayerByToken(std::string_view token) {
     return tokens_.FindPlayerByToken(token);
 }
 
 void Application::SetPlayerAction(model::Player* player, std::string_view action) {
     auto dog = player->GetDog();
     auto dog_speed = player->GetSession()->GetMap()->GetDogSpeed();
+    player->GetSession()->BumpVersion();
 
     if(action == "L"sv) {
-        dog->SetIdle(false);
-        dog->SetDir(model::Direction::WEST);
-        dog->SetVelocity({-dog_speed, 0.0});
+        dog.SetIdle(false);
+        dog.SetDir(model::Direction::WEST);
+        dog.SetVelocity({-dog_speed, 0.0});
     } else if(action == "R"sv) {
-        dog->SetIdle(false);
-        dog->SetDir(model::Direction::EAST);
-        dog->SetVelocity({dog_speed, 0.0});
+        dog.SetIdle(false);
+        dog.SetDir(model::Direction::EAST);
+        dog.SetVelocity({dog_speed, 0.0});
     } else if(action == "U"sv) {
-        dog->SetIdle(false);
-        dog->SetDir(model::Direction::NORTH);
-        dog->SetVelocity({0.0, -dog_speed});
+        dog.SetIdle(false);
+        dog.SetDir(model::Direction::NORTH);
+        dog.SetVelocity({0.0, -dog_speed});
     } else if(action == "D"sv) {
-        dog->SetIdle(false);
-        dog->SetDir(model::Direction::SOUTH);
-        dog->SetVelocity({0.0, dog_speed});
+        dog.SetIdle(false);
+        dog.SetDir(model::Direction::SOUTH);
+        dog.SetVelocity({0.0, dog_speed});
     } else {
-        dog->SetIdle(true);
-        dog->SetVelocity({0.0, 0.0});
+        dog.SetIdle(true);
+        dog.SetVelocity({0.0, 0.0});
     }
 }
 
-geom::Point2D Application::GetRandomPointOnMap(const model::Map* map) {
-    std::uniform_int_distribution<> road_dist(0, map->GetRoads().size() - 1);
-    const auto& road = map->GetRoads()[road_dist(rand_)];
-    std::uniform_real_distribution<> x_dist(std::min(road->GetStart().x, road->GetEnd().x), std::max(road->GetStart().x, road->GetEnd().x));
-    std::uniform_real_distribution<> y_dist(std::min(road->GetStart().y, road->GetEnd().y), std::max(road->GetStart().y, road->GetEnd().y));
-    return {x_dist(rand_), y_dist(rand_)};
+geom::Point2D Application::GetRandomPointOnMap(const model::Map* map, util::CounterRandom& random) {
+    return map->GetRandomPoint(random);
 }
 
-class VectorItemGathererProvider : public collision_detector::ItemGathererProvider {
-public:
-    VectorItemGathererProvider(const std::unordered_map<size_t, std::pair<size_t, geom::Point2D>>& loot,
-                               const std::vector<collision_detector::Item>& bases,
-                               const std::vector<std::pair<model::Dog*, collision_detector::Gatherer>>& gatherers) : gatherers_(gatherers) {
-        loot_data_.reserve(loot.size());
-        items_.reserve(loot.size() + bases.size());
-        for(const auto& [id, item] : loot) {
-            loot_data_.emplace_back(id, item.first);
-            items_.emplace_back(item.second, 0.0);
-        }
-        bases_offset_ = items_.size();
-        items_.insert(items_.end(), bases.begin(), bases.end());
-    }
+void Application::SetTickThreads(unsigned threads) {
+    tick_pool_ = std::make_unique<util::WorkerPool>(threads);
+}
 
-    size_t ItemsCount() const override {
-        return items_.size();
-    }
-    collision_detector::Item GetItem(size_t idx) const override {
-        return items_.at(idx);
-    }
-    size_t GatherersCount() const override {
-        return gatherers_.size();
-    }
-    collision_detector::Gatherer GetGatherer(size_t idx) const override {
-        return gatherers_.at(idx).second;
-    }
+void Application::SetParallelSessionThreshold(size_t dog_count) {
+    parallel_session_threshold_ = dog_count;
+}
 
-    bool IsItemIdx(size_t idx) const {
-        return bases_offset_ != 0 && idx < bases_offset_;
-    }
-    auto& GetLootData(size_t idx) const {
-        return loot_data_.at(idx);
-    }
+void Application::SetGatherMode(collision_detector::GatherMode mode) {
+    gather_mode_ = mode;
+}
 
-    model::Dog* GetDog(size_t idx) const {
-        return gatherers_.at(idx).first;
-    }
+void Application::SetKineticMovement(bool enabled) {
+    kinetic_movement_ = enabled;
+}
 
-private:
-    std::vector<collision_detector::Item> items_;
-    const std::vector<std::pair<model::Dog*, collision_detector::Gatherer>>& gatherers_;
-    size_t bases_offset_{0};
-    std::vector<std::pair<size_t,size_t>> loot_data_;
-};
+void Application::SetFixedPointMovement(bool enabled) {
+    fixed_point_movement_ = enabled;
+}
 
 std::unique_ptr<db::UnitOfWork, void(*)(db::UnitOfWork*)> Application::GetUoW() {
     return database_->GetUoW();
@@ -189,84 +156,193 @@ void Application::AddListener(const std::shared_ptr<ApplicationListener>& listen
 }
 
 void Application::Tick(std::chrono::milliseconds dt) {
-    for(const auto& p : game_.GetSessions()) {
-        const auto& session = p.second;
-        auto map = session->GetMap();
-        
-        //Generate new loot
-        {
-            auto n_new_loot = session->GenerateLoot(dt);
-
-            std::uniform_int_distribution<> loot_obj_distrib(0, map->GetExtraData().GetLootTypes().size() - 1);
-
-            for(size_t i = 0; i < n_new_loot; ++i) {
-                session->AddLoot({loot_obj_distrib(rand_), GetRandomPointOnMap(map)});
+    //сессии без собак спят и не тикаются, а пролежавшие пустыми дольше допустимого освобождаются
+    game_.ReleaseEmptySessions(dt);
+    tick_sessions_.clear();
+    for(const auto& [map_id, sessions] : game_.GetSessions()) {
+        for(const auto& session : sessions) {
+            if(session->GetDogs().Size() != 0) {
+                tick_sessions_.push_back(session.get());
             }
         }
+    }
 
-        std::vector<std::pair<model::Dog*, collision_detector::Gatherer>> gatherers;
+    //буферы привязаны к позиции в списке, а не к сессии: от тика к тику переиспользуется только их память
+    if(tick_buffers_.size() < tick_sessions_.size()) {
+        tick_buffers_.resize(tick_sessions_.size());
+    }
+    tick_pool_->ParallelFor(tick_sessions_.size(), [this, dt](size_t i) {
+        TickSession(*tick_sessions_[i], dt, tick_buffers_[i]);
+    });
+
+    //Notify
+    //слушатели (сохранение состояния, отправка на пенсию) работают с глобальным состоянием,
+    //поэтому вызываются один раз за тик, после того как все сессии посчитаны
+    for (auto it = listeners_.begin(); it != listeners_.end(); ) {
+        if(auto ptr = it->lock()) {
+            ptr->OnTick(dt);
+            ++it;
+        } else {
+            it = listeners_.erase(it);
+        }
+    }
+}
 
-        //Move and tick dogs
-        {
-            for(auto& [dog_id, dog] : session->GetDogs()) {
-                if(dog->GetIdleFor() >= game_.GetMaxIdleTime()) {
-                    //этого быть не должно, но если случилось - то значит что-то с бд
-                    //эти собаки уже "протухли", поэтому мы их не тикаем
-                    //чтобы сохранить их состояние в целости до момента как сможем сохранить их результат в бд
-                    continue;
-                }
+void Application::TickSession(model::GameSession& session, std::chrono::milliseconds dt, TickBuffers& buffers) {
+    auto map = session.GetMap();
+    session.BumpVersion();
 
-                //increase age and idle time
-                dog->SetAge(dog->GetAge() + dt);
-                if(dog->IsIdle()) {
-                    dog->SetIdleFor(dog->GetIdleFor() + dt);
-                } else {
-                    dog->SetIdleFor(std::chrono::milliseconds{0});
-                }
+    //Generate new loot
+    {
+        auto n_new_loot = session.GenerateLoot(dt);
 
-                //move
-                auto old_pos = dog->GetPos();
-                map->MoveDog(dog.get(), dt);
-                gatherers.emplace_back(dog.get(), collision_detector::Gatherer{old_pos, dog->GetPos(), 0.6});
+        for(size_t i = 0; i < n_new_loot; ++i) {
+            auto pos = GetRandomPointOnMap(map, session.GetRandom());
+            if(fixed_point_movement_) {
+                pos = geom::SnapToFixed(pos);
             }
+            session.AddLoot({session.GetRandom().Below(map->GetExtraData().GetLootTypesCount()), pos});
         }
+    }
 
-        //Do item gathering
-        {
-            VectorItemGathererProvider provider(session->GetLoot(), map->GetExtraData().GetBases(), gatherers);
-            auto collision_events = collision_detector::FindGatherEvents(provider);
-            
-            for(const auto& e : collision_events) {
-                auto dog = provider.GetDog(e.gatherer_id);
-
-                if(provider.IsItemIdx(e.item_id)) {
-                    auto [loot_id, loot_type] = provider.GetLootData(e.item_id);
-                    if(dog->TryGrabItem(loot_id, loot_type)) {
-                        session->RemoveLoot(loot_id);
-                    }
-                } else {
-                    for(const auto& item : dog->GetBag()) {
-                        auto type = item.second;
-                        auto value = map->GetExtraData().GetLootTypes().at(type).as_object().at("value").as_int64();
-                        dog->SetScore(dog->GetScore() + value);
+    auto& dogs = session.GetDogs();
+    if(kinetic_movement_) {
+        //собаки, сменившие скорость после прошлого тика, получают траекторию до ближайшей остановки
+        const auto velocities = dogs.GetVelocities();
+        for(const auto slot : dogs.GetActive()) {
+            if(!dogs.HasTrajectory(slot)) {
+                const auto stop = map->FindStop(dogs.GetPos(slot), velocities[slot]);
+                dogs.SetTrajectory(slot, stop.pos, stop.after);
+            }
+        }
+    }
+
+    //возраст и простой стоящих собак считаются от времени сессии, обходить их не нужно
+    dogs.AdvanceTime(dt);
+    dogs.CollectExpired(game_.GetMaxIdleTime(), session.GetExpiredDogs());
+
+    const auto active = dogs.GetActive();
+    const bool parallel = parallel_session_threshold_ != 0 && active.size() >= parallel_session_threshold_;
+
+    //Move dogs
+    //собиратель i - это собака active[i]
+    {
+        auto positions = dogs.GetPositions();
+        auto velocities = dogs.GetVelocities();
+        auto remainders = dogs.GetMoveRemainders();
+        buffers.gatherers.resize(active.size());
+        buffers.stopped.assign(active.size(), false);
+
+        const auto tick_start = dogs.GetTime() - dt;
+        auto move_dogs = [&](size_t first, size_t last) {
+            if(kinetic_movement_) {
+                //позиции вычисляются по траекториям, столбцы позиций не меняются
+                for(size_t i = first; i < last; ++i) {
+                    const auto slot = active[i];
+                    buffers.gatherers[i] = {dogs.GetPosAt(slot, tick_start), dogs.GetPos(slot), 0.6};
+                }
+                return;
+            }
+            if(fixed_point_movement_) {
+                //позиции лежат на сетке фиксированной точки, поэтому переводятся туда и обратно без потерь
+                for(size_t i = first; i < last; ++i) {
+                    const auto slot = active[i];
+                    auto old_pos = positions[slot];
+                    auto pos = geom::ToFixed(old_pos);
+                    auto vel = geom::ToFixed(velocities[slot]);
+                    buffers.stopped[i] = map->MoveDog(pos, vel, dt, remainders[slot]);
+                    positions[slot] = geom::FromFixed(pos);
+                    if(buffers.stopped[i]) {
+                        velocities[slot] = {0.0, 0.0};
                     }
-                    dog->ClearBag();
+                    buffers.gatherers[i] = {old_pos, positions[slot], 0.6};
                 }
+                return;
+            }
+            for(size_t i = first; i < last; ++i) {
+                const auto slot = active[i];
+                auto old_pos = positions[slot];
+                buffers.stopped[i] = map->MoveDog(positions[slot], velocities[slot], dt);
+                buffers.gatherers[i] = {old_pos, positions[slot], 0.6};
             }
+        };
+
+        if(parallel) {
+            //собаки двигаются независимо друг от друга и пишут каждая в свою ячейку буферов
+            const size_t chunks = (active.size() + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+            tick_pool_->ParallelFor(chunks, [&](size_t c) {
+                move_dogs(c * PARALLEL_CHUNK_SIZE, std::min(active.size(), (c + 1) * PARALLEL_CHUNK_SIZE));
+            });
+        } else {
+            move_dogs(0, active.size());
         }
+    }
 
-        //Notify
-        {
-            for (auto it = listeners_.begin(); it != listeners_.end(); ) {
-                if(auto ptr = it->lock()) {
-                    ptr->OnTick(dt);
-                    ++it;
-                } else {
-                    it = listeners_.erase(it);
+    //Do item gathering
+    {
+        //в поиск попадают только трофеи из ячеек индекса рядом с путями движущихся собак
+        buffers.nearby_loot.clear();
+        const auto& loot_index = session.GetLootIndex();
+        for(const auto& g : buffers.gatherers) {
+            const double reach = g.width + collision_detector::BOUNDS_EPSILON;
+            loot_index.Query({std::min(g.start_pos.x, g.end_pos.x) - reach, std::min(g.start_pos.y, g.end_pos.y) - reach},
+                             {std::max(g.start_pos.x, g.end_pos.x) + reach, std::max(g.start_pos.y, g.end_pos.y) + reach},
+                             buffers.nearby_loot);
+        }
+        //упорядочиваем по id, чтобы порядок событий не зависел от раскладки ячеек
+        std::sort(buffers.nearby_loot.begin(), buffers.nearby_loot.end());
+        buffers.nearby_loot.erase(std::unique(buffers.nearby_loot.begin(), buffers.nearby_loot.end()), buffers.nearby_loot.end());
+
+        //сначала трофеи (их id и тип лежат в buffers.loot под тем же индексом), затем базы
+        buffers.items.clear();
+        buffers.loot.clear();
+        const auto& loot_map = session.GetLoot();
+        for(const auto id : buffers.nearby_loot) {
+            const auto& [type, pos] = loot_map.at(id);
+            buffers.loot.emplace_back(id, type);
+            buffers.items.push_back({pos, 0.0});
+        }
+        const auto& bases = map->GetExtraData().GetBases();
+        buffers.items.insert(buffers.items.end(), bases.begin(), bases.end());
+
+        if(parallel) {
+            collision_detector::FindGatherEvents(buffers.items, buffers.gatherers, buffers.events, buffers.scratch, *tick_pool_, PARALLEL_CHUNK_SIZE, gather_mode_);
+        } else {
+            collision_detector::FindGatherEvents(buffers.items, buffers.gatherers, buffers.events, buffers.scratch, gather_mode_);
+        }
+
+        for(const auto& e : buffers.events) {
+            auto dog = dogs[active[e.gatherer_id]];
+
+            if(e.item_id < buffers.loot.size()) {
+                auto [loot_id, loot_type] = buffers.loot[e.item_id];
+                if(dog.TryGrabItem(loot_id, loot_type)) {
+                    session.RemoveLoot(loot_id);
                 }
+            } else {
+                for(const auto& item : dog.GetBag()) {
+                    dog.SetScore(dog.GetScore() + map->GetExtraData().GetLootValue(item.second));
+                }
+                dog.ClearBag();
             }
         }
     }
+
+    //упёршиеся в край дороги собаки уходят в простой в конце тика, пока active нужен для сопоставления собирателей
+    buffers.stopped_slots.clear();
+    if(kinetic_movement_) {
+        //собаки с траекторией уходят в простой с момента остановки внутри тика
+        dogs.CollectStops(buffers.stopped_slots);
+        return;
+    }
+    for(size_t i = 0; i < active.size(); ++i) {
+        if(buffers.stopped[i]) {
+            buffers.stopped_slots.push_back(active[i]);
+        }
+    }
+    for(const auto slot : buffers.stopped_slots) {
+        dogs.SetIdle(slot, true);
+    }
 }
 
 }
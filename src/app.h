@@ -2,6 +2,7 @@
 
 #include "model.h"
 #include "db.h"
+#include "worker_pool.h"
 
 #include <random>
 #include <filesystem>
@@ -14,7 +15,7 @@ static std::random_device RANDOM_DEVICE;
 
 class Players {
 public:
-    const model::PlayerPtr& Add(const model::DogPtr& dog, const model::GameSessionPtr& session);
+    const model::PlayerPtr& Add(size_t dog_id, const model::GameSessionPtr& session);
 
     auto& GetPlayers() const noexcept {
         return players_;
@@ -32,7 +33,7 @@ private:
 
 class PlayerTokens {
 public:
-    std::optional<std::reference_wrapper<const model::PlayerPtr>> FindPlayerByToken(const model::Token& token) const noexcept;
+    std::optional<std::reference_wrapper<const model::PlayerPtr>> FindPlayerByToken(std::string_view token) const noexcept;
     model::Token AddPlayer(const model::PlayerPtr& player);
 
     auto& GetTokens() const noexcept {
@@ -57,8 +58,30 @@ private:
 
     std::string GenerateToken();
 
-    using TokenHasher = util::TaggedHasher<model::Token>;
-    using TokenToPlayer = std::unordered_map<model::Token, model::PlayerPtr, TokenHasher>;
+    // Токен из запроса ищется по string_view, без создания строки
+    struct TokenHasher {
+        using is_transparent = void;
+        size_t operator()(std::string_view token) const noexcept {
+            return std::hash<std::string_view>{}(token);
+        }
+        size_t operator()(const model::Token& token) const noexcept {
+            return (*this)(*token);
+        }
+    };
+    struct TokenEqual {
+        using is_transparent = void;
+        template <typename Lhs, typename Rhs>
+        bool operator()(const Lhs& lhs, const Rhs& rhs) const noexcept {
+            return View(lhs) == View(rhs);
+        }
+        static std::string_view View(std::string_view token) noexcept {
+            return token;
+        }
+        static std::string_view View(const model::Token& token) noexcept {
+            return *token;
+        }
+    };
+    using TokenToPlayer = std::unordered_map<model::Token, model::PlayerPtr, TokenHasher, TokenEqual>;
 
     TokenToPlayer token_to_player_;
     std::unordered_map<size_t, model::Token> player_id_to_token_;
@@ -77,11 +100,28 @@ public:
     const model::Game::Maps& ListMaps() const noexcept;
     const model::Map* FindMap(const model::Map::Id& id) const noexcept;
     std::pair<const model::PlayerPtr&, model::Token> JoinGame(const model::Map::Id& map_id, std::string_view user_name);
-    std::optional<std::reference_wrapper<const model::PlayerPtr>> FindPlayerByToken(const model::Token& token);
+    std::optional<std::reference_wrapper<const model::PlayerPtr>> FindPlayerByToken(std::string_view token);
     
     static void SetPlayerAction(model::Player* player, std::string_view action);
     void Tick(std::chrono::milliseconds dt);
-    geom::Point2D GetRandomPointOnMap(const model::Map* map);
+    // Точка на дорогах карты, выбранная с учётом длины дорог, из потока случайных чисел сессии
+    static geom::Point2D GetRandomPointOnMap(const model::Map* map, util::CounterRandom& random);
+
+    // Сессии разных карт не разделяют состояние, поэтому тикаются параллельно.
+    // threads - число дополнительных потоков, 0 - тикать в вызывающем потоке
+    void SetTickThreads(unsigned threads);
+    // Сессии, в которых не меньше dog_count собак, двигают собак и ищут столкновения в несколько потоков.
+    // 0 - не распараллеливать сессии
+    void SetParallelSessionThreshold(size_t dog_count);
+    // Трофеи и базы лежат на осевых линиях дорог, поэтому кандидатов можно искать по линиям (GatherMode::ROAD_LINES)
+    void SetGatherMode(collision_detector::GatherMode mode);
+    // Собаки движутся по траекториям до ближайшей остановки: тик не вызывает Map::MoveDog для каждой собаки,
+    // а только вычисляет её позицию по времени, поэтому короткий период тика обходится дёшево
+    void SetKineticMovement(bool enabled);
+    // Пошаговое движение и размещение трофеев в фиксированной точке (geom::Fixed): результат симуляции не зависит
+    // от машины и от разбиения времени на тики. Клиенту координаты по-прежнему отдаются в double.
+    // Кинетическое движение, если включено, имеет приоритет
+    void SetFixedPointMovement(bool enabled);
 
     auto& GetGame() const noexcept {
         return game_;
@@ -106,12 +146,37 @@ public:
     std::unique_ptr<db::UnitOfWork, void(*)(db::UnitOfWork*)> GetUoW();
 
 private:
+    // Рабочая память тика одной сессии, переиспользуется между тиками.
+    // Вся временная память тика берётся отсюда, поэтому после прогрева тик не выделяет память (см. tick_allocation_tests)
+    struct TickBuffers {
+        std::vector<collision_detector::Gatherer> gatherers;
+        std::vector<uint8_t> stopped;
+        std::vector<model::DogTable::Slot> stopped_slots;
+        // id трофеев рядом с движущимися собаками
+        std::vector<size_t> nearby_loot;
+        std::vector<collision_detector::Item> items;
+        // id и тип трофея, лежащего в items под тем же индексом
+        std::vector<std::pair<size_t, size_t>> loot;
+        std::vector<collision_detector::GatheringEvent> events;
+        collision_detector::GatherScratch scratch;
+    };
+
+    void TickSession(model::GameSession& session, std::chrono::milliseconds dt, TickBuffers& buffers);
+
     model::Game game_;
     Players players_;
     PlayerTokens tokens_;
-    std::minstd_rand rand_{detail::RANDOM_DEVICE()};
     bool random_spawns_;
     std::vector<std::weak_ptr<ApplicationListener>> listeners_;
+    std::unique_ptr<util::WorkerPool> tick_pool_ = std::make_unique<util::WorkerPool>(0);
+    std::vector<model::GameSession*> tick_sessions_;
+    std::vector<TickBuffers> tick_buffers_;
+    size_t parallel_session_threshold_{0};
+    collision_detector::GatherMode gather_mode_{collision_detector::GatherMode::GRID};
+    bool kinetic_movement_{false};
+    bool fixed_point_movement_{false};
+
+    static constexpr size_t PARALLEL_CHUNK_SIZE = 1024;
     std::unique_ptr<db::Database, void(*)(db::Database*)> database_;
 };
 
@@ -1,56 +1,547 @@
-#include "collision_detector.h"
-#include <cassert>
-
-namespace collision_detector {
-
-bool CollectionResult::IsCollected(double collect_radius) const {
-    return proj_ratio >= 0 && proj_ratio <= 1 && sq_distance <= collect_radius * collect_radius;
-}
-
-CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D c) {
-    const double u_x = c.x - a.x;
-    const double u_y = c.y - a.y;
-    const double v_x = b.x - a.x;
-    const double v_y = b.y - a.y;
-    const double u_dot_v = u_x * v_x + u_y * v_y;
-    const double u_len2 = u_x * u_x + u_y * u_y;
-    const double v_len2 = v_x * v_x + v_y * v_y;
-    const double proj_ratio = u_dot_v / v_len2;
-    const double sq_distance = u_len2 - (u_dot_v * u_dot_v) / v_len2;
-
-    return CollectionResult{sq_distance, proj_ratio};
-}
-
-std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
-    std::vector<GatheringEvent> detected_events;
-
-    for (size_t g = 0; g < provider.GatherersCount(); ++g) {
-        const auto& gatherer = provider.GetGatherer(g);
-        auto start_pos = gatherer.start_pos;
-        auto end_pos = gatherer.end_pos;
-        if (start_pos.x == end_pos.x && start_pos.y == end_pos.y) {
-            continue; // Gatherer doesn't move, skip
-        }
-
-        for (size_t i = 0; i < provider.ItemsCount(); ++i) {
-            const auto& item = provider.GetItem(i);
-            auto item_pos = item.position;
-            auto collect_result = TryCollectPoint(start_pos, end_pos, item_pos);
-
-            double collect_radius = gatherer.width + item.width;
-            if (collect_result.IsCollected(collect_radius)) {
-                detected_events.emplace_back(i, g, collect_result.sq_distance, collect_result.proj_ratio);
-            }
-        }
-    }
-
-    // Sort events by time
-    std::sort(detected_events.begin(), detected_events.end(),
-              [](const auto& e1, const auto& e2) {
-                  return e1.time < e2.time;
-              });
-
-    return detected_events;
-}
-
-}  // namespace collision_detector
+#include "collision_detector.h"
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <tuple>
+
+// Векторные варианты собираются с атрибутом target и выбираются по возможностям процессора во время работы
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define COLLISION_DETECTOR_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace collision_detector {
+
+bool CollectionResult::IsCollected(double collect_radius) const {
+    return proj_ratio >= 0 && proj_ratio <= 1 && sq_distance <= collect_radius * collect_radius;
+}
+
+CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D c) {
+    const double u_x = c.x - a.x;
+    const double u_y = c.y - a.y;
+    const double v_x = b.x - a.x;
+    const double v_y = b.y - a.y;
+    const double u_dot_v = u_x * v_x + u_y * v_y;
+    const double u_len2 = u_x * u_x + u_y * u_y;
+    const double v_len2 = v_x * v_x + v_y * v_y;
+    const double proj_ratio = u_dot_v / v_len2;
+    const double sq_distance = u_len2 - (u_dot_v * u_dot_v) / v_len2;
+
+    return CollectionResult{sq_distance, proj_ratio};
+}
+
+namespace {
+
+// Предметы [first, last) пакета по одному, той же TryCollectPoint
+void TryCollectPointsScalar(const Gatherer& gatherer, const ItemBatch& items, size_t first, size_t last, BatchCollectionResult& result) {
+    for (size_t i = first; i < last; ++i) {
+        const auto collect_result = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, {items.x[i], items.y[i]});
+        result.sq_distance[i] = collect_result.sq_distance;
+        result.proj_ratio[i] = collect_result.proj_ratio;
+        if (collect_result.IsCollected(gatherer.width + items.width[i])) {
+            result.collected |= uint64_t{1} << i;
+        }
+    }
+}
+
+#ifdef COLLISION_DETECTOR_X86_SIMD
+
+// Порядок операций тот же, что в TryCollectPoint и IsCollected. Сравнения упорядоченные, NaN даёт false, как и в скалярном коде
+__attribute__((target("sse2")))
+void TryCollectPointsSse2(const Gatherer& gatherer, const ItemBatch& items, BatchCollectionResult& result) {
+    const double v_x = gatherer.end_pos.x - gatherer.start_pos.x;
+    const double v_y = gatherer.end_pos.y - gatherer.start_pos.y;
+    const __m128d a_x = _mm_set1_pd(gatherer.start_pos.x);
+    const __m128d a_y = _mm_set1_pd(gatherer.start_pos.y);
+    const __m128d vv_x = _mm_set1_pd(v_x);
+    const __m128d vv_y = _mm_set1_pd(v_y);
+    const __m128d v_len2 = _mm_set1_pd(v_x * v_x + v_y * v_y);
+    const __m128d gatherer_width = _mm_set1_pd(gatherer.width);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+
+    const size_t count = items.x.size();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128d u_x = _mm_sub_pd(_mm_loadu_pd(&items.x[i]), a_x);
+        const __m128d u_y = _mm_sub_pd(_mm_loadu_pd(&items.y[i]), a_y);
+        const __m128d u_dot_v = _mm_add_pd(_mm_mul_pd(u_x, vv_x), _mm_mul_pd(u_y, vv_y));
+        const __m128d u_len2 = _mm_add_pd(_mm_mul_pd(u_x, u_x), _mm_mul_pd(u_y, u_y));
+        const __m128d proj_ratio = _mm_div_pd(u_dot_v, v_len2);
+        const __m128d sq_distance = _mm_sub_pd(u_len2, _mm_div_pd(_mm_mul_pd(u_dot_v, u_dot_v), v_len2));
+        const __m128d radius = _mm_add_pd(gatherer_width, _mm_loadu_pd(&items.width[i]));
+
+        const __m128d collected = _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(proj_ratio, zero), _mm_cmple_pd(proj_ratio, one)),
+                                             _mm_cmple_pd(sq_distance, _mm_mul_pd(radius, radius)));
+        _mm_storeu_pd(&result.sq_distance[i], sq_distance);
+        _mm_storeu_pd(&result.proj_ratio[i], proj_ratio);
+        result.collected |= static_cast<uint64_t>(_mm_movemask_pd(collected)) << i;
+    }
+    TryCollectPointsScalar(gatherer, items, i, count, result);
+}
+
+__attribute__((target("avx2")))
+void TryCollectPointsAvx2(const Gatherer& gatherer, const ItemBatch& items, BatchCollectionResult& result) {
+    const double v_x = gatherer.end_pos.x - gatherer.start_pos.x;
+    const double v_y = gatherer.end_pos.y - gatherer.start_pos.y;
+    const __m256d a_x = _mm256_set1_pd(gatherer.start_pos.x);
+    const __m256d a_y = _mm256_set1_pd(gatherer.start_pos.y);
+    const __m256d vv_x = _mm256_set1_pd(v_x);
+    const __m256d vv_y = _mm256_set1_pd(v_y);
+    const __m256d v_len2 = _mm256_set1_pd(v_x * v_x + v_y * v_y);
+    const __m256d gatherer_width = _mm256_set1_pd(gatherer.width);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+
+    const size_t count = items.x.size();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d u_x = _mm256_sub_pd(_mm256_loadu_pd(&items.x[i]), a_x);
+        const __m256d u_y = _mm256_sub_pd(_mm256_loadu_pd(&items.y[i]), a_y);
+        const __m256d u_dot_v = _mm256_add_pd(_mm256_mul_pd(u_x, vv_x), _mm256_mul_pd(u_y, vv_y));
+        const __m256d u_len2 = _mm256_add_pd(_mm256_mul_pd(u_x, u_x), _mm256_mul_pd(u_y, u_y));
+        const __m256d proj_ratio = _mm256_div_pd(u_dot_v, v_len2);
+        const __m256d sq_distance = _mm256_sub_pd(u_len2, _mm256_div_pd(_mm256_mul_pd(u_dot_v, u_dot_v), v_len2));
+        const __m256d radius = _mm256_add_pd(gatherer_width, _mm256_loadu_pd(&items.width[i]));
+
+        const __m256d collected = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(proj_ratio, zero, _CMP_GE_OQ), _mm256_cmp_pd(proj_ratio, one, _CMP_LE_OQ)),
+                                                _mm256_cmp_pd(sq_distance, _mm256_mul_pd(radius, radius), _CMP_LE_OQ));
+        _mm256_storeu_pd(&result.sq_distance[i], sq_distance);
+        _mm256_storeu_pd(&result.proj_ratio[i], proj_ratio);
+        result.collected |= static_cast<uint64_t>(_mm256_movemask_pd(collected)) << i;
+    }
+    TryCollectPointsScalar(gatherer, items, i, count, result);
+}
+
+#endif
+
+SimdLevel DetectSimdLevel() noexcept {
+#ifdef COLLISION_DETECTOR_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SimdLevel::SSE2;
+    }
+#endif
+    return SimdLevel::SCALAR;
+}
+
+}  // namespace
+
+SimdLevel GetSimdLevel() noexcept {
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+void TryCollectPoints(const Gatherer& gatherer, const ItemBatch& items, BatchCollectionResult& result) {
+    TryCollectPoints(gatherer, items, result, GetSimdLevel());
+}
+
+void TryCollectPoints(const Gatherer& gatherer, const ItemBatch& items, BatchCollectionResult& result, SimdLevel level) {
+    assert(items.x.size() <= COLLECT_BATCH_SIZE && items.y.size() == items.x.size() && items.width.size() == items.x.size());
+    result.collected = 0;
+    switch (level) {
+#ifdef COLLISION_DETECTOR_X86_SIMD
+    case SimdLevel::AVX2:
+        TryCollectPointsAvx2(gatherer, items, result);
+        return;
+    case SimdLevel::SSE2:
+        TryCollectPointsSse2(gatherer, items, result);
+        return;
+#endif
+    default:
+        TryCollectPointsScalar(gatherer, items, 0, items.x.size(), result);
+    }
+}
+
+void ItemGrid::Build(std::span<const Item> items) {
+    cell_items_.clear();
+    if (items.empty()) {
+        cols_ = rows_ = 0;
+        return;
+    }
+
+    double max_x = min_x_ = items.front().position.x;
+    double max_y = min_y_ = items.front().position.y;
+    max_width_ = 0;
+    for (const auto& item : items) {
+        min_x_ = std::min(min_x_, item.position.x);
+        min_y_ = std::min(min_y_, item.position.y);
+        max_x = std::max(max_x, item.position.x);
+        max_y = std::max(max_y, item.position.y);
+        max_width_ = std::max(max_width_, item.width);
+    }
+
+    // В среднем около одного предмета на ячейку
+    const double area = std::max(max_x - min_x_, 1.0) * std::max(max_y - min_y_, 1.0);
+    cell_size_ = std::max(MIN_CELL_SIZE, std::sqrt(area / items.size()));
+    cols_ = static_cast<size_t>((max_x - min_x_) / cell_size_) + 1;
+    rows_ = static_cast<size_t>((max_y - min_y_) / cell_size_) + 1;
+
+    item_cells_.resize(items.size());
+    cell_start_.assign(cols_ * rows_ + 1, 0);
+    for (size_t i = 0; i < items.size(); ++i) {
+        item_cells_[i] = CellRow(items[i].position.y) * cols_ + CellCol(items[i].position.x);
+        ++cell_start_[item_cells_[i] + 1];
+    }
+    for (size_t c = 0; c < cols_ * rows_; ++c) {
+        cell_start_[c + 1] += cell_start_[c];
+    }
+    cell_items_.resize(items.size());
+    cell_fill_.assign(cell_start_.begin(), cell_start_.end());
+    for (size_t i = 0; i < items.size(); ++i) {
+        cell_items_[cell_fill_[item_cells_[i]]++] = i;
+    }
+}
+
+void ItemGrid::Query(geom::Point2D min, geom::Point2D max, std::vector<size_t>& out) const {
+    out.clear();
+    if (cell_items_.empty() || max.x < min_x_ || max.y < min_y_) {
+        return;
+    }
+    const auto col_from = CellCol(min.x), col_to = CellCol(max.x);
+    const auto row_from = CellRow(min.y), row_to = CellRow(max.y);
+    for (size_t row = row_from; row <= row_to; ++row) {
+        const auto row_cells = cell_start_.begin() + row * cols_;
+        out.insert(out.end(), cell_items_.begin() + row_cells[col_from], cell_items_.begin() + row_cells[col_to + 1]);
+    }
+    std::sort(out.begin(), out.end());
+}
+
+namespace {
+
+size_t ClampCell(double cell, size_t count) noexcept {
+    return cell <= 0 ? 0 : std::min(static_cast<size_t>(cell), count - 1);
+}
+
+}  // namespace
+
+size_t ItemGrid::CellCol(double x) const noexcept {
+    return ClampCell((x - min_x_) / cell_size_, cols_);
+}
+
+size_t ItemGrid::CellRow(double y) const noexcept {
+    return ClampCell((y - min_y_) / cell_size_, rows_);
+}
+
+void RoadLineIndex::Lines::Clear() {
+    keys.clear();
+    starts.clear();
+    coords.clear();
+    items.clear();
+}
+
+void RoadLineIndex::Lines::Query(double key_min, double key_max, double coord_min, double coord_max, std::vector<size_t>& out) const {
+    for (auto l = static_cast<size_t>(std::lower_bound(keys.begin(), keys.end(), key_min) - keys.begin());
+         l < keys.size() && keys[l] <= key_max; ++l) {
+        const auto line_begin = coords.begin() + starts[l];
+        const auto line_end = coords.begin() + starts[l + 1];
+        for (auto it = std::lower_bound(line_begin, line_end, coord_min); it != line_end && *it <= coord_max; ++it) {
+            out.push_back(items[it - coords.begin()]);
+        }
+    }
+}
+
+void RoadLineIndex::Fill(Lines& lines, std::vector<Entry>& entries, std::vector<Entry>& placed, std::vector<size_t>& line_ends) {
+    if (entries.empty()) {
+        lines.starts.push_back(0);
+        return;
+    }
+
+    const auto [min_entry, max_entry] = std::minmax_element(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.key < rhs.key;
+    });
+    const double min_key = min_entry->key;
+    const double key_span = max_entry->key - min_key;
+    auto by_coord = [](const Entry& lhs, const Entry& rhs) {
+        return std::tie(lhs.coord, lhs.item) < std::tie(rhs.coord, rhs.item);
+    };
+
+    if (key_span >= static_cast<double>(SPARSE_LINES_FACTOR * entries.size())) {
+        // Линии слишком разрежены для раскладки подсчётом
+        std::sort(entries.begin(), entries.end(), [&by_coord](const Entry& lhs, const Entry& rhs) {
+            return lhs.key != rhs.key ? lhs.key < rhs.key : by_coord(lhs, rhs);
+        });
+        placed.swap(entries);
+        line_ends.clear();
+        for (size_t i = 0; i < placed.size(); ++i) {
+            if (i + 1 == placed.size() || placed[i + 1].key != placed[i].key) {
+                line_ends.push_back(i + 1);
+            }
+        }
+    } else {
+        // Ключи линий целые: раскладываем предметы по линиям подсчётом, сортируются только предметы внутри линии
+        line_ends.assign(static_cast<size_t>(key_span) + 1, 0);
+        for (const auto& entry : entries) {
+            ++line_ends[static_cast<size_t>(entry.key - min_key)];
+        }
+        size_t total = 0;
+        for (auto& end : line_ends) {
+            total += end;
+            end = total - end;
+        }
+        placed.resize(entries.size());
+        for (const auto& entry : entries) {
+            placed[line_ends[static_cast<size_t>(entry.key - min_key)]++] = entry;
+        }
+        // Теперь line_ends[k] - конец линии k, пустые линии не нужны
+        line_ends.erase(std::unique(line_ends.begin(), line_ends.end()), line_ends.end());
+        if (line_ends.front() == 0) {
+            line_ends.erase(line_ends.begin());
+        }
+        size_t begin = 0;
+        for (const auto end : line_ends) {
+            std::sort(placed.begin() + begin, placed.begin() + end, by_coord);
+            begin = end;
+        }
+    }
+
+    size_t begin = 0;
+    for (const auto end : line_ends) {
+        lines.keys.push_back(placed[begin].key);
+        lines.starts.push_back(begin);
+        begin = end;
+    }
+    lines.starts.push_back(placed.size());
+    for (const auto& entry : placed) {
+        lines.coords.push_back(entry.coord);
+        lines.items.push_back(entry.item);
+    }
+}
+
+void RoadLineIndex::Build(std::span<const Item> items) {
+    horizontal_.Clear();
+    vertical_.Clear();
+    off_line_.clear();
+    horizontal_entries_.clear();
+    vertical_entries_.clear();
+    max_width_ = 0;
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        const auto pos = items[i].position;
+        if (pos.y == std::floor(pos.y)) {
+            horizontal_entries_.push_back({pos.y, pos.x, i});
+        } else if (pos.x == std::floor(pos.x)) {
+            vertical_entries_.push_back({pos.x, pos.y, i});
+        } else {
+            off_line_.push_back(i);
+        }
+        max_width_ = std::max(max_width_, items[i].width);
+    }
+
+    Fill(horizontal_, horizontal_entries_, placed_, line_ends_);
+    Fill(vertical_, vertical_entries_, placed_, line_ends_);
+}
+
+void RoadLineIndex::Query(geom::Point2D min, geom::Point2D max, std::vector<size_t>& out) const {
+    out.assign(off_line_.begin(), off_line_.end());
+    horizontal_.Query(min.y, max.y, min.x, max.x, out);
+    vertical_.Query(min.x, max.x, min.y, max.y, out);
+    std::sort(out.begin(), out.end());
+}
+
+namespace {
+
+// До COLLECT_BATCH_SIZE предметов, разложенных по столбцам для TryCollectPoints. Живёт на стеке
+class PackedItems {
+public:
+    void Clear() noexcept {
+        size_ = 0;
+    }
+
+    void Add(const Item& item) noexcept {
+        x_[size_] = item.position.x;
+        y_[size_] = item.position.y;
+        width_[size_] = item.width;
+        ++size_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    ItemBatch GetBatch() const noexcept {
+        return {{x_.data(), size_}, {y_.data(), size_}, {width_.data(), size_}};
+    }
+
+private:
+    std::array<double, COLLECT_BATCH_SIZE> x_;
+    std::array<double, COLLECT_BATCH_SIZE> y_;
+    std::array<double, COLLECT_BATCH_SIZE> width_;
+    size_t size_ = 0;
+};
+
+// Проверяет пакет и добавляет события подобранных предметов по возрастанию их места в пакете.
+// item_id(k) - индекс k-го предмета пакета
+template <typename ItemId>
+void CollectBatch(const Gatherer& gatherer, size_t g, const PackedItems& packed, ItemId item_id, std::vector<GatheringEvent>& detected_events) {
+    BatchCollectionResult result;
+    TryCollectPoints(gatherer, packed.GetBatch(), result);
+    for (auto bits = result.collected; bits != 0; bits &= bits - 1) {
+        const auto k = static_cast<size_t>(std::countr_zero(bits));
+        detected_events.emplace_back(item_id(k), g, result.sq_distance[k], result.proj_ratio[k]);
+    }
+}
+
+bool IsMoving(const Gatherer& gatherer) {
+    return gatherer.start_pos.x != gatherer.end_pos.x || gatherer.start_pos.y != gatherer.end_pos.y;
+}
+
+// Предметы проверяются пакетами по COLLECT_BATCH_SIZE. Если все они умещаются в один пакет (так бывает
+// в FindGatherEvents, где перебор идёт до GRID_MIN_ITEMS предметов), пакет собирается один раз на все собиратели
+void FindGatherEventsInRange(std::span<const Item> items, std::span<const Gatherer> gatherers, size_t first, size_t last, std::vector<GatheringEvent>& detected_events) {
+    PackedItems packed;
+    size_t packed_start = items.size();
+    for (size_t g = first; g < last; ++g) {
+        const auto& gatherer = gatherers[g];
+        if (!IsMoving(gatherer)) {
+            continue; // Gatherer doesn't move, skip
+        }
+
+        for (size_t start = 0; start < items.size(); start += COLLECT_BATCH_SIZE) {
+            if (packed_start != start) {
+                packed.Clear();
+                for (const auto& item : items.subspan(start, std::min(COLLECT_BATCH_SIZE, items.size() - start))) {
+                    packed.Add(item);
+                }
+                packed_start = start;
+            }
+            CollectBatch(gatherer, g, packed, [start](size_t k) { return start + k; }, detected_events);
+        }
+    }
+}
+
+// Проверяет только кандидатов из индекса (ItemGrid или RoadLineIndex) рядом с отрезком собирателя, расширенным на радиус сбора.
+// Кандидаты проверяются пакетами по возрастанию индекса, поэтому события идут в том же порядке, что и при полном переборе
+template <typename Index>
+void FindGatherEventsInRange(std::span<const Item> items, std::span<const Gatherer> gatherers, const Index& index, size_t first, size_t last,
+                             std::vector<size_t>& candidates, std::vector<GatheringEvent>& detected_events) {
+    for (size_t g = first; g < last; ++g) {
+        const auto& gatherer = gatherers[g];
+        if (!IsMoving(gatherer)) {
+            continue; // Gatherer doesn't move, skip
+        }
+
+        const double radius = gatherer.width + index.GetMaxItemWidth() + BOUNDS_EPSILON;
+        index.Query({std::min(gatherer.start_pos.x, gatherer.end_pos.x) - radius, std::min(gatherer.start_pos.y, gatherer.end_pos.y) - radius},
+                    {std::max(gatherer.start_pos.x, gatherer.end_pos.x) + radius, std::max(gatherer.start_pos.y, gatherer.end_pos.y) + radius},
+                    candidates);
+        for (size_t start = 0; start < candidates.size(); start += COLLECT_BATCH_SIZE) {
+            const auto batch = std::span{candidates}.subspan(start, std::min(COLLECT_BATCH_SIZE, candidates.size() - start));
+            PackedItems packed;
+            for (auto i : batch) {
+                packed.Add(items[i]);
+            }
+            CollectBatch(gatherer, g, packed, [batch](size_t k) { return batch[k]; }, detected_events);
+        }
+    }
+}
+
+void SortByTime(std::vector<GatheringEvent>& events) {
+    std::sort(events.begin(), events.end(),
+              [](const auto& e1, const auto& e2) {
+                  return e1.time < e2.time;
+              });
+}
+
+}  // namespace
+
+void FindGatherEventsBruteForce(std::span<const Item> items, std::span<const Gatherer> gatherers, std::vector<GatheringEvent>& events) {
+    events.clear();
+    FindGatherEventsInRange(items, gatherers, 0, gatherers.size(), events);
+
+    // Sort events by time
+    SortByTime(events);
+}
+
+void FindGatherEventsWithGrid(std::span<const Item> items, std::span<const Gatherer> gatherers, std::vector<GatheringEvent>& events, GatherScratch& scratch) {
+    events.clear();
+    scratch.grid.Build(items);
+    scratch.candidates.resize(std::max<size_t>(scratch.candidates.size(), 1));
+    FindGatherEventsInRange(items, gatherers, scratch.grid, 0, gatherers.size(), scratch.candidates.front(), events);
+
+    // Sort events by time
+    SortByTime(events);
+}
+
+void FindGatherEventsOnRoadLines(std::span<const Item> items, std::span<const Gatherer> gatherers, std::vector<GatheringEvent>& events, GatherScratch& scratch) {
+    events.clear();
+    scratch.road_lines.Build(items);
+    scratch.candidates.resize(std::max<size_t>(scratch.candidates.size(), 1));
+    FindGatherEventsInRange(items, gatherers, scratch.road_lines, 0, gatherers.size(), scratch.candidates.front(), events);
+
+    // Sort events by time
+    SortByTime(events);
+}
+
+void FindGatherEvents(std::span<const Item> items, std::span<const Gatherer> gatherers, std::vector<GatheringEvent>& events, GatherScratch& scratch,
+                      GatherMode mode) {
+    if (items.size() < GRID_MIN_ITEMS) {
+        FindGatherEventsBruteForce(items, gatherers, events);
+    } else if (mode == GatherMode::ROAD_LINES) {
+        FindGatherEventsOnRoadLines(items, gatherers, events, scratch);
+    } else {
+        FindGatherEventsWithGrid(items, gatherers, events, scratch);
+    }
+}
+
+void FindGatherEvents(std::span<const Item> items, std::span<const Gatherer> gatherers, std::vector<GatheringEvent>& events, GatherScratch& scratch,
+                      util::WorkerPool& pool, size_t chunk_size, GatherMode mode) {
+    assert(chunk_size > 0);
+    const size_t chunks = (gatherers.size() + chunk_size - 1) / chunk_size;
+
+    const bool use_index = items.size() >= GRID_MIN_ITEMS;
+    const bool use_road_lines = use_index && mode == GatherMode::ROAD_LINES;
+    if (use_road_lines) {
+        scratch.road_lines.Build(items);
+    } else if (use_index) {
+        scratch.grid.Build(items);
+    }
+
+    // размер только растёт, чтобы буферы блоков переиспользовались между вызовами
+    if (scratch.chunk_events.size() < chunks) {
+        scratch.chunk_events.resize(chunks);
+        scratch.candidates.resize(chunks);
+    }
+    pool.ParallelFor(chunks, [&](size_t c) {
+        const auto last = std::min(gatherers.size(), (c + 1) * chunk_size);
+        auto& chunk_events = scratch.chunk_events[c];
+        chunk_events.clear();
+        if (use_road_lines) {
+            FindGatherEventsInRange(items, gatherers, scratch.road_lines, c * chunk_size, last, scratch.candidates[c], chunk_events);
+        } else if (use_index) {
+            FindGatherEventsInRange(items, gatherers, scratch.grid, c * chunk_size, last, scratch.candidates[c], chunk_events);
+        } else {
+            FindGatherEventsInRange(items, gatherers, c * chunk_size, last, chunk_events);
+        }
+    });
+
+    // std::sort неустойчива, поэтому вход сортировки должен совпадать с последовательной версией
+    events.clear();
+    for (size_t c = 0; c < chunks; ++c) {
+        events.insert(events.end(), scratch.chunk_events[c].begin(), scratch.chunk_events[c].end());
+    }
+    SortByTime(events);
+}
+
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
+    std::vector<Item> items;
+    items.reserve(provider.ItemsCount());
+    for (size_t i = 0; i < provider.ItemsCount(); ++i) {
+        items.push_back(provider.GetItem(i));
+    }
+    std::vector<Gatherer> gatherers;
+    gatherers.reserve(provider.GatherersCount());
+    for (size_t g = 0; g < provider.GatherersCount(); ++g) {
+        gatherers.push_back(provider.GetGatherer(g));
+    }
+
+    std::vector<GatheringEvent> events;
+    GatherScratch scratch;
+    FindGatherEvents(items, gatherers, events, scratch);
+    return events;
+}
+
+}  // namespace collision_detector
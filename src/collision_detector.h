@@ -1,8 +1,12 @@
 #pragma once
 
 #include "geom.h"
+#include "worker_pool.h"
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
 #include <vector>
 
 namespace collision_detector {
@@ -32,6 +36,38 @@ struct Gatherer {
     double width;
 };
 
+// Пакетная проверка: один собиратель против пакета предметов, разложенного по столбцам
+constexpr size_t COLLECT_BATCH_SIZE = 64;
+
+struct ItemBatch {
+    std::span<const double> x;
+    std::span<const double> y;
+    std::span<const double> width;
+};
+
+struct BatchCollectionResult {
+    // Бит i установлен, если собиратель подбирает предмет i
+    uint64_t collected;
+    // Значения CollectionResult для каждого предмета пакета, смысл имеют для подобранных
+    std::array<double, COLLECT_BATCH_SIZE> sq_distance;
+    std::array<double, COLLECT_BATCH_SIZE> proj_ratio;
+};
+
+enum class SimdLevel {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Лучший из наборов инструкций, поддерживаемых процессором
+SimdLevel GetSimdLevel() noexcept;
+
+// Проверяет до COLLECT_BATCH_SIZE предметов за вызов. Вычисления повторяют TryCollectPoint операция в операцию
+// и без FMA, поэтому решения совпадают с TryCollectPoint и IsCollected бит в бит на любом уровне
+void TryCollectPoints(const Gatherer& gatherer, const ItemBatch& items, BatchCollectionResult& result);
+// Вариант с заданным уровнем, не выше GetSimdLevel(): для тестов и замеров
+void TryCollectPoints(const Gatherer& gatherer, const ItemBatch& items, BatchCollectionResult& result, SimdLevel level);
+
 class ItemGathererProvider {
 protected:
     ~ItemGathererProvider() = default;
@@ -50,6 +86,136 @@ struct GatheringEvent {
     double time;
 };
 
+// Начиная с этого числа предметов кандидаты отбираются по сетке, а не полным перебором.
+// Точка выбрана по tests/gather_events_benchmark.cpp
+constexpr size_t GRID_MIN_ITEMS = 8;
+// Запас к радиусу при отборе кандидатов по сетке на погрешность вычислений
+constexpr double BOUNDS_EPSILON = 1e-6;
+
+// Равномерная сетка над предметами: каждый предмет лежит в одной ячейке по своей позиции.
+// Ячейки хранятся подряд (CSR), внутри ячейки предметы идут по возрастанию индекса.
+// Повторный Build переиспользует память предыдущего
+class ItemGrid {
+public:
+    void Build(std::span<const Item> items);
+
+    double GetMaxItemWidth() const noexcept {
+        return max_width_;
+    }
+
+    // Индексы предметов из ячеек, пересекающих прямоугольник, по возрастанию
+    void Query(geom::Point2D min, geom::Point2D max, std::vector<size_t>& out) const;
+
+private:
+    static constexpr double MIN_CELL_SIZE = 1.0;
+
+    size_t CellCol(double x) const noexcept;
+    size_t CellRow(double y) const noexcept;
+
+    double min_x_{0};
+    double min_y_{0};
+    double max_width_{0};
+    double cell_size_{MIN_CELL_SIZE};
+    size_t cols_{0};
+    size_t rows_{0};
+    std::vector<size_t> item_cells_;
+    std::vector<size_t> cell_start_;
+    std::vector<size_t> cell_fill_;
+    std::vector<size_t> cell_items_;
+};
+
+// Предметы, разложенные по осевым линиям дорог. Предмет с целой координатой y лежит на горизонтальной
+// линии, иначе с целой x - на вертикальной. Внутри линии предметы отсортированы по координате вдоль неё,
+// так что поиск в прямоугольнике сводится к двоичным поискам по линиям и по координатам на линии.
+// Предметы вне линий возвращаются любым запросом. Повторный Build переиспользует память предыдущего
+class RoadLineIndex {
+public:
+    void Build(std::span<const Item> items);
+
+    double GetMaxItemWidth() const noexcept {
+        return max_width_;
+    }
+
+    // Индексы предметов, лежащих в прямоугольнике, и предметов вне линий, по возрастанию
+    void Query(geom::Point2D min, geom::Point2D max, std::vector<size_t>& out) const;
+
+private:
+    // Линии одного направления по возрастанию координаты линии.
+    // Предметы линии l занимают [starts[l], starts[l + 1]) в coords и items
+    struct Lines {
+        std::vector<double> keys;
+        std::vector<size_t> starts;
+        std::vector<double> coords;
+        std::vector<size_t> items;
+
+        void Clear();
+        void Query(double key_min, double key_max, double coord_min, double coord_max, std::vector<size_t>& out) const;
+    };
+
+    struct Entry {
+        double key;
+        double coord;
+        size_t item;
+    };
+
+    // Если линий больше, чем SPARSE_LINES_FACTOR на предмет, линии упорядочиваются сортировкой, а не подсчётом
+    static constexpr size_t SPARSE_LINES_FACTOR = 4;
+
+    static void Fill(Lines& lines, std::vector<Entry>& entries, std::vector<Entry>& placed, std::vector<size_t>& line_ends);
+
+    Lines horizontal_;
+    Lines vertical_;
+    std::vector<size_t> off_line_;
+    std::vector<Entry> horizontal_entries_;
+    std::vector<Entry> vertical_entries_;
+    std::vector<Entry> placed_;
+    std::vector<size_t> line_ends_;
+    double max_width_{0};
+};
+
+// Способ отбора кандидатов при поиске событий. До GRID_MIN_ITEMS предметов в любом режиме используется перебор
+enum class GatherMode {
+    // Равномерная сетка ItemGrid, подходит для любого расположения предметов
+    GRID,
+    // Линии дорог RoadLineIndex, для предметов, лежащих на осевых линиях дорог
+    ROAD_LINES
+};
+
+// Рабочая память поиска событий. Хранится вызывающим между тиками, чтобы поиск не выделял память
+struct GatherScratch {
+    ItemGrid grid;
+    RoadLineIndex road_lines;
+    // По одному буферу на блок собирателей
+    std::vector<std::vector<size_t>> candidates;
+    std::vector<std::vector<GatheringEvent>> chunk_events;
+};
+
+// Ищет события по непрерывным массивам предметов и собирателей и записывает их в events
+// (прежнее содержимое удаляется), отсортированными по времени
+void FindGatherEvents(std::span<const Item> items, std::span<const Gatherer> gatherers,
+                      std::vector<GatheringEvent>& events, GatherScratch& scratch,
+                      GatherMode mode = GatherMode::GRID);
+
+// То же самое, но собиратели делятся на блоки по chunk_size, которые обрабатываются в пуле.
+// Результаты блоков склеиваются в порядке собирателей до сортировки,
+// поэтому порядок событий совпадает с последовательной версией
+void FindGatherEvents(std::span<const Item> items, std::span<const Gatherer> gatherers,
+                      std::vector<GatheringEvent>& events, GatherScratch& scratch,
+                      util::WorkerPool& pool, size_t chunk_size, GatherMode mode = GatherMode::GRID);
+
+// Полный перебор всех пар собиратель-предмет
+void FindGatherEventsBruteForce(std::span<const Item> items, std::span<const Gatherer> gatherers,
+                                std::vector<GatheringEvent>& events);
+// Перебор только предметов из ячеек сетки рядом с отрезком собирателя.
+// Результат и порядок событий совпадают с полным перебором
+void FindGatherEventsWithGrid(std::span<const Item> items, std::span<const Gatherer> gatherers,
+                              std::vector<GatheringEvent>& events, GatherScratch& scratch);
+// Перебор только предметов на линиях дорог рядом с отрезком собирателя и предметов вне линий.
+// Результат и порядок событий совпадают с полным перебором
+void FindGatherEventsOnRoadLines(std::span<const Item> items, std::span<const Gatherer> gatherers,
+                                 std::vector<GatheringEvent>& events, GatherScratch& scratch);
+
+// Обёртка над ItemGathererProvider: копирует предметы и собирателей и ищет по ним
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
 
 }  // namespace collision_detector
\ No newline at end of file
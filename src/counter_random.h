@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace util {
+
+// Генератор со счётчиком: n-е число потока - хеш пары (seed, n), состояние сводится к этим двум числам.
+// Поток можно сохранить, восстановить и воспроизвести с любого места, а у разных сессий потоки независимы.
+// Удовлетворяет UniformRandomBitGenerator, поэтому подходит и для распределений из <random>
+class CounterRandom {
+public:
+    using result_type = uint64_t;
+
+    explicit CounterRandom(uint64_t seed = 0) noexcept
+        : seed_{seed} {
+    }
+
+    static constexpr result_type min() noexcept {
+        return 0;
+    }
+
+    static constexpr result_type max() noexcept {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() noexcept {
+        return Mix(seed_ + GOLDEN_GAMMA * ++counter_);
+    }
+
+    // Случайное число из [0, n), n > 0. Смещение не больше n / 2^64
+    uint64_t Below(uint64_t n) noexcept {
+        return static_cast<uint64_t>((static_cast<unsigned __int128>((*this)()) * n) >> 64);
+    }
+
+    // Случайное число из [0, 1) с 53 значащими битами
+    double Canonical() noexcept {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // Начинает новый поток с нулевым счётчиком
+    void Seed(uint64_t seed) noexcept {
+        seed_ = seed;
+        counter_ = 0;
+    }
+
+    uint64_t GetSeed() const noexcept {
+        return seed_;
+    }
+
+    // Сколько чисел выдано с начала потока
+    uint64_t GetCounter() const noexcept {
+        return counter_;
+    }
+
+    void SetCounter(uint64_t counter) noexcept {
+        counter_ = counter;
+    }
+
+    // Зерно потока с номером stream, производное от общего зерна
+    static uint64_t DeriveSeed(uint64_t seed, uint64_t stream) noexcept {
+        return Mix(seed ^ Mix(stream + GOLDEN_GAMMA));
+    }
+
+private:
+    static constexpr uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15;
+
+    // Финализатор SplitMix64
+    static uint64_t Mix(uint64_t z) noexcept {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t seed_;
+    uint64_t counter_{0};
+};
+
+}  // namespace util
@@ -1,6 +1,11 @@
 #include "extra_data.h"
 
-ExtraData::ExtraData(boost::json::array loot) : loot_types_(std::move(loot)) {}
+ExtraData::ExtraData(boost::json::array loot) : loot_types_(std::move(loot)) {
+    loot_values_.reserve(loot_types_.size());
+    for (const auto& loot_type : loot_types_) {
+        loot_values_.push_back(loot_type.as_object().at("value").as_int64());
+    }
+}
 
 void ExtraData::AddBase(collision_detector::Item item) {
     bases_.emplace_back(std::move(item));
@@ -4,16 +4,29 @@
 
 #include <boost/json.hpp>
 
+#include <cstdint>
 #include <vector>
 
 class ExtraData {
 public:
+    // Исходное описание типов трофеев отдаётся клиенту как есть,
+    // а нужные симуляции значения извлекаются из него один раз при загрузке
     explicit ExtraData(boost::json::array loot);
 
+    // JSON-описание типов трофеев для ответа клиенту
     const auto& GetLootTypes() const noexcept {
         return loot_types_;
     }
 
+    size_t GetLootTypesCount() const noexcept {
+        return loot_values_.size();
+    }
+
+    // Сколько очков приносит трофей типа type
+    std::int64_t GetLootValue(size_t type) const {
+        return loot_values_.at(type);
+    }
+
     const auto& GetBases() const noexcept {
         return bases_;
     }
@@ -22,5 +35,6 @@ public:
 
 private:
     boost::json::array loot_types_;
+    std::vector<std::int64_t> loot_values_;
     std::vector<collision_detector::Item> bases_;
-};
\ No newline at end of file
+};
@@ -0,0 +1,26 @@
+#include "fixed_timestep.h"
+
+#include <cassert>
+
+namespace app {
+
+FixedTimestep::FixedTimestep(std::chrono::milliseconds step, unsigned max_steps)
+    : step_{step}
+    , max_steps_{max_steps} {
+    assert(step_.count() > 0 && max_steps_ > 0);
+}
+
+unsigned FixedTimestep::Advance(std::chrono::milliseconds elapsed) {
+    accumulated_ += elapsed;
+    auto steps = static_cast<unsigned long long>(accumulated_ / step_);
+    accumulated_ %= step_;
+
+    if (steps > max_steps_) {
+        ++overruns_;
+        dropped_ += (steps - max_steps_) * step_;
+        steps = max_steps_;
+    }
+    return static_cast<unsigned>(steps);
+}
+
+}  // namespace app
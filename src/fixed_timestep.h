@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+
+namespace app {
+
+// Накопитель реального времени для симуляции с фиксированным шагом.
+// Прошедшее время копится и расходуется целыми шагами step, остаток переносится на следующий вызов.
+// Если за один вызов набралось больше max_steps шагов, лишнее время отбрасывается,
+// чтобы после долгой паузы симуляция не пыталась догнать всё пропущенное разом
+class FixedTimestep {
+public:
+    FixedTimestep(std::chrono::milliseconds step, unsigned max_steps);
+
+    // Добавляет прошедшее время и возвращает число шагов, которые нужно выполнить
+    unsigned Advance(std::chrono::milliseconds elapsed);
+
+    std::chrono::milliseconds GetStep() const noexcept {
+        return step_;
+    }
+
+    // Сколько вызовов Advance упёрлись в max_steps
+    size_t GetOverruns() const noexcept {
+        return overruns_;
+    }
+
+    // Сколько времени отброшено из-за ограничения на число шагов
+    std::chrono::milliseconds GetDroppedTime() const noexcept {
+        return dropped_;
+    }
+
+private:
+    std::chrono::milliseconds step_;
+    unsigned max_steps_;
+    std::chrono::milliseconds accumulated_{0};
+    size_t overruns_{0};
+    std::chrono::milliseconds dropped_{0};
+};
+
+}  // namespace app
@@ -3,6 +3,7 @@
 #include <compare>
 #include <cstddef>
 #include <cmath>
+#include <cstdint>
 #include <functional>
 
 namespace geom {
@@ -93,4 +94,61 @@ inline Point2D operator+(const Vec2D& lhs, Point2D rhs) {
     return rhs += lhs;
 }
 
+// Фиксированная точка: координаты и скорости в 1/FIXED_ONE доли клетки (скорость - в таких долях в секунду).
+// Целочисленная арифметика не зависит от процессора и компилятора, а значения точно представимы в double
+using Fixed = int32_t;
+
+constexpr int FIXED_SHIFT = 10;
+constexpr Fixed FIXED_ONE = Fixed{1} << FIXED_SHIFT;
+
+constexpr Fixed ToFixed(double value) noexcept {
+    const double scaled = value * FIXED_ONE;
+    // Округление к ближайшему, половина - от нуля, как у std::round
+    return static_cast<Fixed>(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+constexpr double FromFixed(Fixed value) noexcept {
+    return static_cast<double>(value) / FIXED_ONE;
+}
+
+// Клетка, в которой лежит координата (ближайшее целое, половина - от нуля, как у std::round)
+constexpr Coord FixedToCell(Fixed value) noexcept {
+    return value < 0 ? -((-value + FIXED_ONE / 2) >> FIXED_SHIFT) : (value + FIXED_ONE / 2) >> FIXED_SHIFT;
+}
+
+constexpr Fixed CellToFixed(Coord cell) noexcept {
+    return cell * FIXED_ONE;
+}
+
+struct FixedPoint2D {
+    auto operator<=>(const FixedPoint2D&) const = default;
+
+    Fixed x = 0;
+    Fixed y = 0;
+};
+
+struct FixedVec2D {
+    auto operator<=>(const FixedVec2D&) const = default;
+
+    Fixed x = 0;
+    Fixed y = 0;
+};
+
+inline FixedPoint2D ToFixed(Point2D p) noexcept {
+    return {ToFixed(p.x), ToFixed(p.y)};
+}
+
+inline FixedVec2D ToFixed(Vec2D v) noexcept {
+    return {ToFixed(v.x), ToFixed(v.y)};
+}
+
+inline Point2D FromFixed(FixedPoint2D p) noexcept {
+    return {FromFixed(p.x), FromFixed(p.y)};
+}
+
+// Ближайшая к p точка сетки фиксированной точки
+inline Point2D SnapToFixed(Point2D p) noexcept {
+    return FromFixed(ToFixed(p));
+}
+
 }  // namespace geom
@@ -19,13 +19,20 @@ void SessionBase::Run() {
 }
 
 void SessionBase::Read() {
-    // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз)
-    request_ = {};
-    stream_.expires_after(30s);
+    // Очищаем запрос от прежнего значения (метод Read может быть вызван несколько раз).
+    // Парсер дописывает поля и тело к сообщению, поэтому их очищаем на месте: тело сохраняет ёмкость
+    request_.clear();
+    request_.body().clear();
+    timer_.expires_after(30s);
+    timer_.async_wait(PooledHandler{[weak_self = std::weak_ptr{GetSharedThis()}](beast::error_code ec) {
+        if (auto self = weak_self.lock()) {
+            self->OnTimeout(ec);
+        }
+    }});
     // Считываем request_ из stream_, используя buffer_ для хранения считанных данных
     http::async_read(stream_, buffer_, request_,
                      // По окончании операции будет вызван метод OnRead
-                     beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
+                     PooledHandler{beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis())});
 }
 
 void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
@@ -36,10 +43,13 @@ void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t byte
     if (ec) {
         return ReportError(ec, "read"sv);
     }
-    HandleRequest(std::move(request_));
+    HandleRequest(request_);
 }
 
 void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    // Открытый файл прошлого ответа больше не нужен
+    file_response_.body().close();
+
     if (ec) {
         return ReportError(ec, "write"sv);
     }
@@ -53,9 +63,19 @@ void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std
     Read();
 }
 
+void SessionBase::OnTimeout(beast::error_code ec) {
+    // Таймер отменён или уже перезапущен следующим запросом
+    if (ec == net::error::operation_aborted || timer_.expiry() > Timer::clock_type::now()) {
+        return;
+    }
+    // Закрытие сокета прерывает ожидающую операцию чтения или записи
+    stream_.close(ec);
+}
+
 void SessionBase::Close() {
+    timer_.cancel();
     beast::error_code ec;
-    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+    stream_.shutdown(tcp::socket::shutdown_send, ec);
     if (ec) {
         return ReportError(ec, "close"sv);
     }
@@ -1,10 +1,15 @@
 #pragma once
 #include "sdk.h"
+#include "recycling_allocator.h"
 //
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <boost/beast/websocket/rfc6455.hpp>
+
+#include <utility>
 
 namespace http_server {
 
@@ -16,6 +21,47 @@ namespace sys = boost::system;
 
 void ReportError(beast::error_code ec, std::string_view what);
 
+// Заголовки и тела сообщений живут в пуле памяти потока: на keep-alive соединении память прошлого запроса
+// и ответа достаётся следующему, а не возвращается в кучу
+using Fields = http::basic_fields<util::RecyclingAllocator<char>>;
+using StringBody = http::basic_string_body<char, std::char_traits<char>, util::RecyclingAllocator<char>>;
+using StringRequest = http::request<StringBody, Fields>;
+using StringResponse = http::response<StringBody, Fields>;
+using FileResponse = http::response<http::file_body, Fields>;
+
+// Обработчик завершения асинхронной операции, состояние которой (парсер, сериализатор) берётся из пула потока.
+// asio и beast находят аллокатор через allocator_type и get_allocator
+template <typename Handler>
+class PooledHandler {
+public:
+    using allocator_type = util::RecyclingAllocator<void>;
+
+    explicit PooledHandler(Handler handler)
+        : handler_(std::move(handler)) {
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return {};
+    }
+
+    template <typename... Args>
+    void operator()(Args&&... args) {
+        handler_(std::forward<Args>(args)...);
+    }
+
+private:
+    Handler handler_;
+};
+
+// Сокет и таймер сессии работают в strand известного типа: any_io_executor не вмещает strand
+// и копирует его в кучу при каждом запуске асинхронной операции
+using Strand = net::strand<net::io_context::executor_type>;
+using Socket = tcp::socket::rebind_executor<Strand>::other;
+using Timer = net::basic_waitable_timer<std::chrono::steady_clock, net::wait_traits<std::chrono::steady_clock>, Strand>;
+
+// Разрешает нескольким сокетам слушать один порт. Ядро распределяет входящие соединения между ними
+using ReusePort = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
 class SessionBase {
 public:
     // Запрещаем копирование и присваивание объектов SessionBase и его наследников
@@ -24,59 +70,86 @@ public:
 
     void Run();
 protected:
-    using HttpRequest = http::request<http::string_body>;
+    using HttpRequest = StringRequest;
 
-    explicit SessionBase(tcp::socket&& socket)
-        : stream_(std::move(socket)) {
+    explicit SessionBase(Socket&& socket)
+        : stream_(std::move(socket))
+        , timer_(stream_.get_executor()) {
     }
 
-    template <typename Body, typename Fields>
-    void Write(http::response<Body, Fields>&& response) {
-        // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
-        auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
+    // Ответ переносится в поле сессии, которое живёт до конца асинхронной записи
+    void Write(StringResponse&& response) {
+        string_response_ = std::move(response);
+        AsyncWrite(string_response_);
+    }
 
-        auto self = GetSharedThis();
-        http::async_write(stream_, *safe_response,
-                          [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-                              self->OnWrite(safe_response->need_eof(), ec, bytes_written);
-                          });
+    void Write(FileResponse&& response) {
+        file_response_ = std::move(response);
+        AsyncWrite(file_response_);
     }
 
     ~SessionBase() = default;
 
-    // tcp_stream содержит внутри себя сокет и добавляет поддержку таймаутов
-    beast::tcp_stream stream_;
+    Socket stream_;
 
 private:
     void Read();
+
+    template <typename Body>
+    void AsyncWrite(http::response<Body, Fields>& response) {
+        http::async_write(stream_, response,
+                          PooledHandler{[&response, self = GetSharedThis()](beast::error_code ec, std::size_t bytes_written) {
+                              self->OnWrite(response.need_eof(), ec, bytes_written);
+                          }});
+    }
+
     void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
     void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
     void Close();
+    void OnTimeout(beast::error_code ec);
 
-    // Обработку запроса делегируем подклассу
-    virtual void HandleRequest(HttpRequest&& request) = 0;
+    // Обработку запроса делегируем подклассу. Запрос остаётся в сессии до отправки ответа
+    virtual void HandleRequest(HttpRequest& request) = 0;
 
     virtual std::shared_ptr<SessionBase> GetSharedThis() = 0;
 
+    // Ограничивает время обмена запросом и ответом. beast::tcp_stream держит свой таймер
+    // в any_io_executor, поэтому таймаут реализован здесь
+    Timer timer_;
     beast::flat_buffer buffer_;
+    // Запрос и ответ переиспользуются всеми обменами keep-alive соединения: строки тела
+    // сохраняют ёмкость, а узлы заголовков возвращаются в пул потока и берутся из него снова
     HttpRequest request_;
+    StringResponse string_response_;
+    FileResponse file_response_;
 };
 
 template <typename RequestHandler>
 class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
 public:
     template <typename Handler>
-    Session(tcp::socket&& socket, Handler&& request_handler)
+    Session(Socket&& socket, Handler&& request_handler)
         : SessionBase(std::move(socket))
         , request_handler_(std::forward<Handler>(request_handler)) {
     }
 private:
-    void HandleRequest(HttpRequest&& request) override {
+    void HandleRequest(HttpRequest& request) override {
+        // Обработчик, который можно вызвать как handler(request, socket), сам обслуживает запросы
+        // на переход к WebSocket: получает сокет, и HTTP-сессия на этом завершается
+        if constexpr (std::is_invocable_v<RequestHandler&, HttpRequest&&, Socket&&>) {
+            if (beast::websocket::is_upgrade(request)) {
+                return request_handler_(std::move(request), std::move(stream_));
+            }
+        }
         // Захватываем умный указатель на текущий объект Session в лямбде,
         // чтобы продлить время жизни сессии до вызова лямбды.
-        // Используется generic-лямбда функция, способная принять response произвольного типа
-        request_handler_(std::move(request), stream_.socket().remote_endpoint(), [self = this->shared_from_this()](auto&& response) {
-            self->Write(std::move(response));
+        // Используется generic-лямбда функция, способная принять response произвольного типа.
+        // Ответ может прийти из чужого потока (например, из strand игры), поэтому запись
+        // запускается в strand сессии. Если send вызван в нём же, запись начинается сразу
+        request_handler_(std::as_const(request), stream_.remote_endpoint(), [self = this->shared_from_this()](auto&& response) {
+            net::dispatch(self->stream_.get_executor(), PooledHandler{[self, response = std::move(response)]() mutable {
+                self->Write(std::move(response));
+            }});
         });
     }
 
@@ -90,8 +163,9 @@ private:
 template <typename RequestHandler>
 class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
 public:
+    // reuse_port - разделить порт с другими Listener (по одному на io_context)
     template <typename Handler>
-    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler)
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler, bool reuse_port = false)
         : ioc_(ioc)
         // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
         , acceptor_(net::make_strand(ioc))
@@ -104,6 +178,9 @@ public:
         // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
         // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
         acceptor_.set_option(net::socket_base::reuse_address(true));
+        if (reuse_port) {
+            acceptor_.set_option(ReusePort(true));
+        }
         // Привязываем acceptor к адресу и порту endpoint
         acceptor_.bind(endpoint);
         // Переводим acceptor в состояние, в котором он способен принимать новые соединения
@@ -115,6 +192,11 @@ public:
         DoAccept();
     }
 
+    // Адрес, на котором принимаются соединения. Полезен, если порт выбран системой (порт 0)
+    tcp::endpoint GetLocalEndpoint() const {
+        return acceptor_.local_endpoint();
+    }
+
 private:
     void DoAccept() {
         acceptor_.async_accept(
@@ -133,7 +215,7 @@ private:
     }
 
     // Метод socket::async_accept создаст сокет и передаст его передан в OnAccept
-    void OnAccept(sys::error_code ec, tcp::socket socket) {
+    void OnAccept(sys::error_code ec, Socket socket) {
         using namespace std::literals;
 
         if (ec) {
@@ -147,7 +229,7 @@ private:
         DoAccept();
     }
 
-    void AsyncRunSession(tcp::socket&& socket) {
+    void AsyncRunSession(Socket&& socket) {
         std::make_shared<Session<RequestHandler>>(std::move(socket), request_handler_)->Run();
     }
 
@@ -157,12 +239,12 @@ private:
 };
 
 template <typename RequestHandler>
-void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler) {
+void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler, bool reuse_port = false) {
     // При помощи decay_t исключим ссылки из типа RequestHandler,
     // чтобы Listener хранил RequestHandler по значению
     using MyListener = Listener<std::decay_t<RequestHandler>>;
 
-    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler), reuse_port)->Run();
 }
 
 }  // namespace http_server
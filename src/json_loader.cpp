@@ -1,5 +1,6 @@
 #include "json_loader.h"
 #include <boost/json.hpp>
+#include <cmath>
 #include <iterator>
 #include <fstream>
 
@@ -28,13 +29,13 @@ model::Building ParseBuilding(boost::json::value& building_v) {
     return model::Building{{pos, size}};
 }
 
-std::unique_ptr<model::Road> ParseRoad(boost::json::value& road_v) {
+model::Road ParseRoad(boost::json::value& road_v) {
     auto& road_json = road_v.as_object();
     geom::Point start{static_cast<geom::Coord>(road_json.at("x0").as_int64()), static_cast<geom::Coord>(road_json.at("y0").as_int64())};
     if(road_json.contains(X1)) {
-        return std::make_unique<model::Road>(model::Road::HORIZONTAL, start, static_cast<geom::Coord>(road_json.at(X1).as_int64()));
+        return {model::Road::HORIZONTAL, start, static_cast<geom::Coord>(road_json.at(X1).as_int64())};
     }
-    return std::make_unique<model::Road>(model::Road::VERTICAL, start, static_cast<geom::Coord>(road_json.at("y1").as_int64()));
+    return {model::Road::VERTICAL, start, static_cast<geom::Coord>(road_json.at("y1").as_int64())};
 }
 
 model::Map ParseMap(boost::json::value& map_v, double default_dog_speed, size_t default_bag_capacity) {
@@ -101,6 +102,23 @@ model::Game LoadGame(const std::filesystem::path& json_path) {
         });
     }
 
+    if(root.as_object().contains("emptySessionLifetime")) {
+        // Время в секундах может быть записано и целым числом
+        const auto lifetime = root.as_object()["emptySessionLifetime"].to_number<double>();
+        if(!std::isfinite(lifetime) || lifetime < 0) {
+            throw std::runtime_error("emptySessionLifetime must be a non-negative number, got " + std::to_string(lifetime));
+        }
+        game.SetEmptySessionLifetime(std::chrono::milliseconds{static_cast<int64_t>(lifetime * 1000.0)});
+    }
+
+    if(root.as_object().contains("maxPlayersPerSession")) {
+        const auto max_players = root.as_object()["maxPlayersPerSession"].as_int64();
+        if(max_players < 0) {
+            throw std::runtime_error("maxPlayersPerSession must not be negative, got " + std::to_string(max_players));
+        }
+        game.SetMaxPlayersPerSession(static_cast<size_t>(max_players));
+    }
+
     auto& maps = root.as_object().at("maps").as_array();
 
     for(auto& map_v : maps) {
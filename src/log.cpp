@@ -5,6 +5,8 @@
 #include <boost/log/utility/setup/console.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include <utility>
+
 namespace logging
 {
 
@@ -24,7 +26,11 @@ void LogFormatter(boostlog::record_view const& rec, boostlog::formatting_ostream
 }
 
 void LOG_INFO(json::value data, std::string message) {
-    BOOST_LOG_TRIVIAL(info) << boostlog::add_value(timestamp, boost::posix_time::microsec_clock::local_time())
+    LOG_INFO(boost::posix_time::microsec_clock::local_time(), std::move(data), std::move(message));
+}
+
+void LOG_INFO(boost::posix_time::ptime time, json::value data, std::string message) {
+    BOOST_LOG_TRIVIAL(info) << boostlog::add_value(timestamp, time)
                             << boostlog::add_value(additional_data, data)
                             << boostlog::add_value(custom_message, message);
 }
@@ -35,4 +41,98 @@ void BootstrapLogging() {
     sink->set_formatter(&LogFormatter);
 }
 
+AccessLog::AccessLog()
+    : ring_(CAPACITY)
+    , worker_{[this](std::stop_token stop) {
+        Run(stop);
+    }} {
+    for(auto& entry : ring_) {
+        entry.text.reserve(TEXT_RESERVE);
+    }
+}
+
+void AccessLog::LogRequest(const boost::asio::ip::address& ip, std::string_view uri, std::string_view method) {
+    const auto time = boost::posix_time::microsec_clock::local_time();
+    Push([&](Entry& entry) {
+        entry.is_request = true;
+        entry.time = time;
+        entry.ip = ip;
+        entry.method = method;
+        entry.has_text = true;
+        entry.text.assign(uri);
+    });
+}
+
+void AccessLog::LogResponse(int64_t response_time, unsigned code, std::optional<std::string_view> content_type) {
+    const auto time = boost::posix_time::microsec_clock::local_time();
+    Push([&](Entry& entry) {
+        entry.is_request = false;
+        entry.time = time;
+        entry.response_time = response_time;
+        entry.code = code;
+        entry.has_text = content_type.has_value();
+        entry.text.assign(content_type.value_or(std::string_view{}));
+    });
+}
+
+size_t AccessLog::GetOverflowed() const {
+    std::lock_guard lock{mutex_};
+    return overflowed_;
+}
+
+template <typename Fill>
+void AccessLog::Push(Fill&& fill) {
+    {
+        std::lock_guard lock{mutex_};
+        if(!overflow_.empty() || size_ == ring_.size()) {
+            fill(overflow_.emplace_back());
+            ++overflowed_;
+        } else {
+            fill(ring_[(first_ + size_) % ring_.size()]);
+            ++size_;
+        }
+    }
+    ready_.notify_one();
+}
+
+void AccessLog::Run(std::stop_token stop) {
+    Entry entry;
+    entry.text.reserve(TEXT_RESERVE);
+    while(true) {
+        {
+            std::unique_lock lock{mutex_};
+            // После запроса остановки ожидание сразу возвращает наличие записей, и журнал дописывается до конца
+            if(!ready_.wait(lock, stop, [this] { return size_ != 0 || !overflow_.empty(); })) {
+                return;
+            }
+            // Записи кольца старше записей очереди переполнения
+            if(size_ != 0) {
+                std::swap(entry, ring_[first_]);
+                first_ = (first_ + 1) % ring_.size();
+                --size_;
+            } else {
+                std::swap(entry, overflow_.front());
+                overflow_.pop_front();
+            }
+        }
+        Write(entry);
+    }
+}
+
+void AccessLog::Write(const Entry& entry) {
+    const json::string_view text{entry.text};
+    if(entry.is_request) {
+        LOG_INFO(entry.time, {{"ip", entry.ip.to_string()}, {"URI", text}, {"method", json::string_view{entry.method.data(), entry.method.size()}}},
+                 "request received");
+        return;
+    }
+    json::object data{{"response_time", entry.response_time}, {"code", entry.code}};
+    if(entry.has_text) {
+        data["content_type"] = text;
+    } else {
+        data["content_type"] = nullptr;
+    }
+    LOG_INFO(entry.time, std::move(data), "response sent");
+}
+
 } // namespace log
@@ -1,8 +1,20 @@
 #pragma once
 
+#include <boost/asio/ip/address.hpp>
+#include <boost/date_time/posix_time/ptime.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/json.hpp>
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
 namespace logging
 {
 
@@ -11,8 +23,62 @@ namespace json = boost::json;
 
 void BootstrapLogging();
 void LOG_INFO(json::value data, std::string message);
+// Запись с заданным временем события
+void LOG_INFO(boost::posix_time::ptime time, json::value data, std::string message);
 
-} // namespace log
+// Журнал HTTP-запросов и ответов. Потоки сервера копируют поля записи в кольцо, выделенное заранее,
+// а json собирает и пишет в Boost.Log отдельный поток, поэтому запись в журнал не обращается к куче.
+// Если поток журнала отстал и кольцо заполнено, записи копятся в очереди переполнения в куче:
+// поток сервера не ждёт журнал, и записи не теряются
+class AccessLog {
+public:
+    static constexpr size_t CAPACITY = 1024;
+    // Буфер текста в каждой ячейке кольца. Более длинный URI не обрезается: буфер ячейки растёт и остаётся таким
+    static constexpr size_t TEXT_RESERVE = 256;
+
+    AccessLog();
+
+    AccessLog(const AccessLog&) = delete;
+    AccessLog& operator=(const AccessLog&) = delete;
 
+    void LogRequest(const boost::asio::ip::address& ip, std::string_view uri, std::string_view method);
+    // content_type не задан, если в ответе нет такого заголовка
+    void LogResponse(int64_t response_time, unsigned code, std::optional<std::string_view> content_type);
 
+    // Сколько записей не поместилось в кольцо и ушло в очередь переполнения
+    size_t GetOverflowed() const;
 
+private:
+    struct Entry {
+        bool is_request = false;
+        boost::posix_time::ptime time;
+        boost::asio::ip::address ip;
+        // Имя метода HTTP, статическая строка
+        std::string_view method;
+        int64_t response_time = 0;
+        unsigned code = 0;
+        bool has_text = false;
+        // URI запроса или тип содержимого ответа. Строка не передаётся между потоками, а обменивается
+        // с ячейкой кольца, поэтому её буфер переиспользуется
+        std::string text;
+    };
+
+    // Заполняет свободную ячейку кольца или новую запись очереди переполнения. Поток журнала увидит запись после возврата
+    template <typename Fill>
+    void Push(Fill&& fill);
+    void Run(std::stop_token stop);
+    static void Write(const Entry& entry);
+
+    mutable std::mutex mutex_;
+    std::condition_variable_any ready_;
+    std::vector<Entry> ring_;
+    size_t first_ = 0;
+    size_t size_ = 0;
+    // Записи новее всех записей кольца. Пока очередь не пуста, новые записи идут в неё, чтобы не нарушить порядок
+    std::deque<Entry> overflow_;
+    size_t overflowed_ = 0;
+    // Уничтожается первым: перед остановкой поток дописывает записи, оставшиеся в кольце
+    std::jthread worker_;
+};
+
+} // namespace log
@@ -6,6 +6,8 @@
 #include "retirement.h"
 #include "postgres.h"
 #include "ticker.h"
+#include "reactor_pool.h"
+#include "state_publisher.h"
 
 #include <boost/program_options.hpp>
 #include <boost/asio/io_context.hpp>
@@ -36,6 +38,12 @@ void RunWorkers(unsigned n, const Fn& fn) {
     fn();
 }
 
+// Объединяет несколько лямбд в один объект с перегруженным operator()
+template <typename... Fns>
+struct Overloaded : Fns... {
+    using Fns::operator()...;
+};
+
 }  // namespace
 
 constexpr const char DB_URL_ENV_NAME[]{"GAME_DB_URL"};
@@ -47,6 +55,15 @@ struct Args {
     bool randomize_spawn_points;
     boost::optional<std::string> state_file;
     boost::optional<int> save_state_period;
+    unsigned tick_threads;
+    size_t parallel_session_threshold;
+    unsigned max_catch_up_ticks;
+    bool road_line_collisions;
+    bool kinetic_movement;
+    bool fixed_point_movement;
+    boost::optional<uint64_t> random_seed;
+    unsigned reactors;
+    bool pin_reactors;
 }; 
 
 [[nodiscard]] std::optional<Args> ParseCommandLine(int argc, const char* const argv[]) {
@@ -62,7 +79,16 @@ struct Args {
         ("www-root,w", po::value(&args.www_root)->value_name("dir"s), "set static files root")
         ("randomize-spawn-points", po::bool_switch(&args.randomize_spawn_points)->default_value(false, ""), "spawn dogs at random positions")
         ("state-file", po::value(&args.state_file)->value_name("file"s), "set state file path")
-        ("save-state-period", po::value(&args.save_state_period)->value_name("milliseconds"s)->default_value(boost::none, ""), "set save state period");
+        ("save-state-period", po::value(&args.save_state_period)->value_name("milliseconds"s)->default_value(boost::none, ""), "set save state period")
+        ("tick-threads", po::value(&args.tick_threads)->value_name("count"s)->default_value(0), "set number of extra threads used to tick game sessions")
+        ("parallel-session-threshold", po::value(&args.parallel_session_threshold)->value_name("dogs"s)->default_value(0), "tick sessions with at least this many dogs on several threads (0 - never)")
+        ("max-catch-up-ticks", po::value(&args.max_catch_up_ticks)->value_name("count"s)->default_value(0), "advance the game in fixed tick-period steps, at most this many per timer tick (0 - one step of real elapsed time)")
+        ("road-line-collisions", po::bool_switch(&args.road_line_collisions)->default_value(false, ""), "look up loot and offices by road lines instead of a uniform grid")
+        ("kinetic-movement", po::bool_switch(&args.kinetic_movement)->default_value(false, ""), "move dogs along precomputed trajectories instead of stepping each dog every tick")
+        ("fixed-point-movement", po::bool_switch(&args.fixed_point_movement)->default_value(false, ""), "step dogs and place loot in fixed-point coordinates for reproducible simulation")
+        ("random-seed", po::value(&args.random_seed)->value_name("seed"s)->default_value(boost::none, ""), "seed random spawn points and loot of every session for a reproducible game")
+        ("reactors", po::value(&args.reactors)->value_name("count"s)->default_value(0), "serve HTTP on this many independent io_contexts sharing the port via SO_REUSEPORT (0 - one io_context on all hardware threads)")
+        ("pin-reactors", po::bool_switch(&args.pin_reactors)->default_value(false, ""), "pin each reactor thread to its own CPU core");
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
     po::notify(vm);
@@ -112,16 +138,37 @@ int main(int argc, const char* argv[]) {
                 , args->randomize_spawn_points
                 , postgres::CreateDatabaseImpl(1, [db_url] { return std::make_shared<pqxx::connection>(db_url); })
         };
+        application.SetTickThreads(args->tick_threads);
+        application.SetParallelSessionThreshold(args->parallel_session_threshold);
+        if(args->road_line_collisions) {
+            application.SetGatherMode(collision_detector::GatherMode::ROAD_LINES);
+        }
+        application.SetKineticMovement(args->kinetic_movement);
+        application.SetFixedPointMovement(args->fixed_point_movement);
+        if(args->random_seed) {
+            application.GetGame().SetRandomSeed(*args->random_seed);
+        }
 
-        // 2. Инициализируем io_context
-        const unsigned num_threads = std::thread::hardware_concurrency();
+        // 2. Инициализируем io_context.
+        // В режиме реакторов HTTP обслуживают отдельные io_context, а в ioc остаются только
+        // strand игры, тикер и сигналы, ему хватает одного потока
+        // Реакторы объявлены раньше ioc и уничтожаются после него: задания api_strand, оставшиеся в ioc
+        // при остановке, держат сессии с сокетами реакторов. Обратных ссылок на strand игры у сессий нет
+        std::optional<util::ReactorPool> reactors;
+        if(args->reactors) {
+            reactors.emplace(args->reactors);
+        }
+        const unsigned num_threads = args->reactors ? 1 : std::thread::hardware_concurrency();
         net::io_context ioc(num_threads);
 
         // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
         net::signal_set signals(ioc, SIGINT, SIGTERM);
-        signals.async_wait([&ioc](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
+        signals.async_wait([&ioc, &reactors](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
             if (!ec) {
                 ioc.stop();
+                if(reactors) {
+                    reactors->Stop();
+                }
             }
         });
 
@@ -129,26 +176,53 @@ int main(int argc, const char* argv[]) {
         // strand для выполнения запросов к API
         auto api_strand = net::make_strand(ioc);
 
+        std::shared_ptr<app::Ticker> ticker;
         if(args->tick_period) {
-            auto ticker = std::make_shared<app::Ticker>(api_strand, std::chrono::milliseconds(*args->tick_period),
+            ticker = std::make_shared<app::Ticker>(api_strand, std::chrono::milliseconds(*args->tick_period),
                 [&application](std::chrono::milliseconds delta) { application.Tick(delta); }
             );
+            if(args->max_catch_up_ticks > 0) {
+                ticker->SetFixedTimestep(args->max_catch_up_ticks);
+            }
             ticker->Start();
         }
 
         auto handler = std::make_shared<http_handler::RequestHandler>(application, args->www_root, api_strand, !args->tick_period.has_value());
+        // Журнал запросов пишется отдельным потоком, чтобы не форматировать json на пути ответа
+        logging::AccessLog access_log;
         http_handler::LoggingRequestHandler logging_handler{
             [handler](auto&& req, auto&& send) {
                 (*handler)(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
-        }};
+        }, access_log};
 
         // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
         const auto address = net::ip::make_address("0.0.0.0");
         constexpr net::ip::port_type port = 8080;
 
-        http_server::ServeHttp(ioc, {address, port}, [&logging_handler](auto&& req, auto&& endpoint, auto&& send) {
-            logging_handler(std::forward<decltype(req)>(req), std::forward<decltype(endpoint)>(endpoint), std::forward<decltype(send)>(send));
-        });
+        auto state_publisher = std::make_shared<http_handler::StatePublisher>(application, api_strand);
+
+        const auto serve_http = [&logging_handler, &state_publisher, &address](net::io_context& http_ioc, bool reuse_port) {
+            http_server::ServeHttp(http_ioc, {address, port}, Overloaded{
+                [&logging_handler](auto&& req, auto&& endpoint, auto&& send) {
+                    logging_handler(std::forward<decltype(req)>(req), std::forward<decltype(endpoint)>(endpoint), std::forward<decltype(send)>(send));
+                },
+                // Запросы на переход к WebSocket
+                // Слабая ссылка: сессии реакторов переживают ioc, а StatePublisher держит его strand
+                [weak_publisher = std::weak_ptr{state_publisher}](http_server::StringRequest&& req, http_server::Socket&& socket) {
+                    if(auto publisher = weak_publisher.lock()) {
+                        publisher->Subscribe(std::move(req), std::move(socket));
+                    }
+                }
+            }, reuse_port);
+        };
+        if(reactors) {
+            // Запросы к API из всех реакторов по-прежнему выполняются в api_strand
+            for(size_t i = 0; i < reactors->Size(); ++i) {
+                serve_http((*reactors)[i], true);
+            }
+        } else {
+            serve_http(ioc, false);
+        }
 
         // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
         logging::LOG_INFO({{"port", port}, {"address", address.to_string()}}, "server started");
@@ -167,11 +241,33 @@ int main(int argc, const char* argv[]) {
         }
         auto retire_listener = std::make_shared<retirement::RetirementListener>(application);
         application.AddListener(retire_listener);
+        // Состояние для подписчиков WebSocket рассылается после тика, когда ушедшие на пенсию уже удалены
+        application.AddListener(state_publisher);
+        // Отложенные запросы состояния отпускаются тогда же, когда рассылается новое состояние
+        application.AddListener(handler);
 
         // 6. Запускаем обработку асинхронных операций
-        RunWorkers(std::max(1u, num_threads), [&ioc] {
-            ioc.run();
-        });
+        if(reactors) {
+            std::jthread game_thread{[&ioc] {
+                ioc.run();
+            }};
+            reactors->Run(args->pin_reactors);
+        } else {
+            RunWorkers(std::max(1u, num_threads), [&ioc] {
+                ioc.run();
+            });
+        }
+
+        if(ticker && ticker->GetFixedTimestep()) {
+            const auto& fixed_timestep = *ticker->GetFixedTimestep();
+            logging::LOG_INFO({{"overruns", fixed_timestep.GetOverruns()}, {"dropped_ms", fixed_timestep.GetDroppedTime().count()}}, "fixed timestep stats");
+        }
+        if(ticker && ticker->GetFailedTicks() > 0) {
+            logging::LOG_INFO({{"failed_ticks", ticker->GetFailedTicks()}}, "ticks failed");
+        }
+        if(access_log.GetOverflowed() > 0) {
+            logging::LOG_INFO({{"overflowed", access_log.GetOverflowed()}}, "access log overflow");
+        }
 
         //В этой точке все асинхронные операции уже выполнены, можно спокойно сохранять
         if(save_listener) {
@@ -1,5 +1,7 @@
 #include "model.h"
 
+#include <cassert>
+#include <algorithm>
 #include <stdexcept>
 #include <cmath>
 
@@ -7,25 +9,305 @@ namespace model {
 using namespace std::literals;
 
 size_t Dog::id_counter_{0};
+std::atomic<uint64_t> GameSession::next_uid_{0};
 
-const DogPtr& GameSession::CreateDog(std::string_view name, geom::Point2D pos) {
-    auto dog = std::make_shared<Dog>(name, pos, geom::Vec2D{}, map_->GetBagCapacity());
-    return dogs_.emplace(dog->GetId(), std::move(dog)).first->second;
+DogRef GameSession::CreateDog(std::string_view name, geom::Point2D pos) {
+    return AddDog(Dog{name, pos, geom::Vec2D{}, map_->GetBagCapacity()});
 }
 
-std::optional<std::reference_wrapper<const DogPtr>> GameSession::GetDogById(size_t id) const {
-    if (auto it = dogs_.find(id); it != dogs_.end()) {
-        return it->second;
+std::optional<DogRef> GameSession::GetDogById(size_t id) {
+    if (auto slot = dogs_.FindSlot(id)) {
+        return dogs_[*slot];
     }
     return std::nullopt;
 }
 
+void GameSession::AddLoot(std::pair<size_t, geom::Point2D> loot, size_t id) {
+    const auto [it, inserted] = loot_map_.emplace(id == 0 ? ++loot_id_: id, std::move(loot));
+    if (inserted) {
+        loot_index_.Add(it->first, it->second.second);
+    }
+}
+
+void GameSession::RemoveLoot(size_t idx) {
+    if (auto it = loot_map_.find(idx); it != loot_map_.end()) {
+        loot_index_.Remove(idx, it->second.second);
+        loot_map_.erase(it);
+    }
+}
+
+void LootIndex::Add(size_t loot_id, geom::Point2D pos) {
+    cells_[MakeKey(ToCell(pos.x), ToCell(pos.y))].push_back(loot_id);
+    ++size_;
+}
+
+void LootIndex::Remove(size_t loot_id, geom::Point2D pos) {
+    auto cell = cells_.find(MakeKey(ToCell(pos.x), ToCell(pos.y)));
+    if (cell == cells_.end()) {
+        return;
+    }
+    auto& ids = cell->second;
+    auto it = std::find(ids.begin(), ids.end(), loot_id);
+    if (it == ids.end()) {
+        return;
+    }
+    *it = ids.back();
+    ids.pop_back();
+    --size_;
+    if (ids.empty()) {
+        cells_.erase(cell);
+    }
+}
+
+void LootIndex::Query(geom::Point2D min, geom::Point2D max, std::vector<size_t>& out) const {
+    if (cells_.empty()) {
+        return;
+    }
+    const auto min_x = ToCell(min.x);
+    const auto max_x = ToCell(max.x);
+    const auto min_y = ToCell(min.y);
+    const auto max_y = ToCell(max.y);
+    for (auto y = min_y; y <= max_y; ++y) {
+        for (auto x = min_x; x <= max_x; ++x) {
+            if (auto cell = cells_.find(MakeKey(x, y)); cell != cells_.end()) {
+                out.insert(out.end(), cell->second.begin(), cell->second.end());
+            }
+        }
+    }
+}
+
 bool Dog::TryGrabItem(size_t id, size_t type) {
     if(bag_.size() >= bag_capacity_) return false;
     bag_.emplace_back(id, type);
     return true;
 }
 
+DogTable::Slot DogTable::Add(const Dog& dog) {
+    if (id_to_slot_.contains(dog.GetId())) {
+        throw std::invalid_argument("Duplicate dog id");
+    }
+    if (dog.GetBagCapacity() > bag_stride_) {
+        ResizeBags(dog.GetBagCapacity());
+    }
+
+    const Slot slot = ids_.size();
+    ids_.push_back(dog.GetId());
+    positions_.push_back(dog.GetPos());
+    velocities_.push_back(dog.GetVelocity());
+    move_remainders_.push_back(0);
+    directions_.push_back(dog.GetDir());
+    idle_.push_back(dog.IsIdle());
+    joined_at_.push_back(now_ - dog.GetAge());
+    idle_since_.push_back(now_ - dog.GetIdleFor());
+    moved_at_.push_back(now_);
+    stop_at_.push_back(NO_TRAJECTORY);
+    stop_pos_.push_back(dog.GetPos());
+    active_pos_.push_back(NOT_ACTIVE);
+    scores_.push_back(dog.GetScore());
+    names_.emplace_back(dog.GetName());
+    bag_capacities_.push_back(dog.GetBagCapacity());
+    bag_sizes_.push_back(dog.GetBag().size());
+    bag_items_.resize(ids_.size() * bag_stride_);
+    std::copy(dog.GetBag().begin(), dog.GetBag().end(), bag_items_.begin() + slot * bag_stride_);
+    id_to_slot_.emplace(dog.GetId(), slot);
+    if (dog.IsIdle()) {
+        idle_queue_.emplace(idle_since_[slot], dog.GetId());
+    } else {
+        Activate(slot);
+    }
+    return slot;
+}
+
+bool DogTable::Remove(size_t dog_id) {
+    auto it = id_to_slot_.find(dog_id);
+    if (it == id_to_slot_.end()) {
+        return false;
+    }
+    const Slot slot = it->second;
+    const Slot last = ids_.size() - 1;
+    id_to_slot_.erase(it);
+    if (!idle_[slot]) {
+        Deactivate(slot);
+    }
+
+    if (slot != last) {
+        ids_[slot] = ids_[last];
+        positions_[slot] = positions_[last];
+        velocities_[slot] = velocities_[last];
+        move_remainders_[slot] = move_remainders_[last];
+        directions_[slot] = directions_[last];
+        idle_[slot] = idle_[last];
+        joined_at_[slot] = joined_at_[last];
+        idle_since_[slot] = idle_since_[last];
+        moved_at_[slot] = moved_at_[last];
+        stop_at_[slot] = stop_at_[last];
+        stop_pos_[slot] = stop_pos_[last];
+        active_pos_[slot] = active_pos_[last];
+        if (active_pos_[slot] != NOT_ACTIVE) {
+            active_[active_pos_[slot]] = slot;
+        }
+        scores_[slot] = scores_[last];
+        names_[slot] = std::move(names_[last]);
+        bag_capacities_[slot] = bag_capacities_[last];
+        bag_sizes_[slot] = bag_sizes_[last];
+        std::copy_n(bag_items_.begin() + last * bag_stride_, bag_stride_, bag_items_.begin() + slot * bag_stride_);
+        id_to_slot_[ids_[slot]] = slot;
+    }
+
+    ids_.pop_back();
+    positions_.pop_back();
+    velocities_.pop_back();
+    move_remainders_.pop_back();
+    directions_.pop_back();
+    idle_.pop_back();
+    joined_at_.pop_back();
+    idle_since_.pop_back();
+    moved_at_.pop_back();
+    stop_at_.pop_back();
+    stop_pos_.pop_back();
+    active_pos_.pop_back();
+    scores_.pop_back();
+    names_.pop_back();
+    bag_capacities_.pop_back();
+    bag_sizes_.pop_back();
+    bag_items_.resize(ids_.size() * bag_stride_);
+    return true;
+}
+
+std::optional<DogTable::Slot> DogTable::FindSlot(size_t dog_id) const {
+    if (auto it = id_to_slot_.find(dog_id); it != id_to_slot_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+Dog DogTable::Extract(Slot slot) const {
+    Dog dog{names_[slot], GetPos(slot), velocities_[slot], bag_capacities_[slot], ids_[slot]};
+    dog.SetDir(directions_[slot]);
+    dog.SetScore(scores_[slot]);
+    dog.SetAge(GetAge(slot));
+    dog.SetIdleFor(GetIdleFor(slot));
+    dog.SetIdle(idle_[slot]);
+    for (const auto& [id, type] : GetBag(slot)) {
+        dog.TryGrabItem(id, type);
+    }
+    return dog;
+}
+
+void DogTable::SetIdle(Slot slot, bool idle) {
+    if (idle_[slot] == idle) {
+        return;
+    }
+    if (idle) {
+        StartIdle(slot, now_);
+    } else {
+        idle_[slot] = false;
+        Activate(slot);
+    }
+}
+
+void DogTable::StartIdle(Slot slot, std::chrono::milliseconds since) {
+    // Простаивающая собака стоит на месте
+    idle_[slot] = true;
+    Materialize(slot);
+    Deactivate(slot);
+    idle_since_[slot] = since;
+    idle_queue_.emplace(since, ids_[slot]);
+}
+
+void DogTable::CollectExpired(std::chrono::milliseconds max_idle, std::vector<size_t>& out) {
+    while (!idle_queue_.empty() && idle_queue_.top().first + max_idle <= now_) {
+        const auto [idle_since, dog_id] = idle_queue_.top();
+        idle_queue_.pop();
+        if (auto slot = FindSlot(dog_id); slot && idle_[*slot] && idle_since_[*slot] == idle_since) {
+            out.push_back(dog_id);
+        }
+    }
+}
+
+void DogTable::SetTrajectory(Slot slot, geom::Point2D stop_pos, std::chrono::milliseconds travel_time) {
+    Materialize(slot);
+    moved_at_[slot] = now_;
+    stop_at_[slot] = now_ + travel_time;
+    stop_pos_[slot] = stop_pos;
+    stop_queue_.emplace(stop_at_[slot], ids_[slot]);
+}
+
+geom::Point2D DogTable::GetPosAt(Slot slot, std::chrono::milliseconds t) const noexcept {
+    if (stop_at_[slot] == NO_TRAJECTORY) {
+        return positions_[slot];
+    }
+    if (t >= stop_at_[slot]) {
+        return stop_pos_[slot];
+    }
+    static constexpr double millis_per_second = 1000.0;
+    const double seconds = (t - moved_at_[slot]).count() / millis_per_second;
+    const auto from = positions_[slot];
+    const auto to = stop_pos_[slot];
+    const auto vel = velocities_[slot];
+    // Время остановки округлено вверх, поэтому точку остановки нельзя проскочить
+    return {std::clamp(from.x + vel.x * seconds, std::min(from.x, to.x), std::max(from.x, to.x)),
+            std::clamp(from.y + vel.y * seconds, std::min(from.y, to.y), std::max(from.y, to.y))};
+}
+
+void DogTable::Materialize(Slot slot) noexcept {
+    if (stop_at_[slot] == NO_TRAJECTORY) {
+        return;
+    }
+    positions_[slot] = GetPos(slot);
+    stop_at_[slot] = NO_TRAJECTORY;
+}
+
+void DogTable::CollectStops(std::vector<Slot>& out) {
+    while (!stop_queue_.empty() && stop_queue_.top().first <= now_) {
+        const auto [stop_at, dog_id] = stop_queue_.top();
+        stop_queue_.pop();
+        if (auto slot = FindSlot(dog_id); slot && stop_at_[*slot] == stop_at) {
+            velocities_[*slot] = {0, 0};
+            StartIdle(*slot, stop_at);
+            out.push_back(*slot);
+        }
+    }
+}
+
+void DogTable::Activate(Slot slot) {
+    active_pos_[slot] = active_.size();
+    active_.push_back(slot);
+}
+
+void DogTable::Deactivate(Slot slot) {
+    const auto pos = active_pos_[slot];
+    active_[pos] = active_.back();
+    active_pos_[active_[pos]] = pos;
+    active_.pop_back();
+    active_pos_[slot] = NOT_ACTIVE;
+}
+
+void DogTable::ResizeBags(size_t stride) {
+    std::vector<BagItem> items(ids_.size() * stride);
+    for (Slot slot = 0; slot < ids_.size(); ++slot) {
+        std::copy_n(bag_items_.begin() + slot * bag_stride_, bag_sizes_[slot], items.begin() + slot * stride);
+    }
+    bag_items_ = std::move(items);
+    bag_stride_ = stride;
+}
+
+void DogRef::SetIdleFor(std::chrono::milliseconds idle_for) const {
+    dogs_->idle_since_[slot_] = dogs_->now_ - idle_for;
+    if (IsIdle()) {
+        dogs_->idle_queue_.emplace(dogs_->idle_since_[slot_], GetId());
+    }
+}
+
+bool DogRef::TryGrabItem(size_t id, size_t type) const {
+    auto& size = dogs_->bag_sizes_[slot_];
+    if (size >= dogs_->bag_capacities_[slot_]) {
+        return false;
+    }
+    dogs_->bag_items_[slot_ * dogs_->bag_stride_ + size++] = {id, type};
+    return true;
+}
+
 void Map::AddOffice(Office office) {
     if (warehouse_id_to_index_.contains(office.GetId())) {
         throw std::invalid_argument("Duplicate warehouse");
@@ -43,12 +325,27 @@ void Map::AddOffice(Office office) {
     }
 }
 
-void Map::AddRoad(std::unique_ptr<Road> road) {
-    roads_.emplace_back(std::move(road));
-    road_grid_.AddRoad(roads_.back().get());
+void Map::AddRoad(const Road& road) {
+    for (const auto& p : {road.GetStart(), road.GetEnd()}) {
+        max_extent_ = std::max({max_extent_, std::abs(p.x), std::abs(p.y)});
+    }
+    roads_.push_back(road);
+    road_grid_.AddRoad(&road);
+    road_graph_.AddRoad(road);
+    road_sampler_.AddRoad(road);
+}
+
+geom::Point2D Map::GetRandomPoint(util::CounterRandom& random) const {
+    const auto& road = roads_[road_sampler_.Sample(random())];
+    const auto start = road.GetStart();
+    const auto end = road.GetEnd();
+    const double t = random.Canonical();
+    return {start.x + t * (end.x - start.x), start.y + t * (end.y - start.y)};
 }
 
 void Game::AddMap(Map map) {
+    map.BuildRoadGraph();
+    map.BuildRoadSampler();
     const size_t index = maps_.size();
     if (auto [it, inserted] = map_id_to_index_.emplace(map.GetId(), index); !inserted) {
         throw std::invalid_argument("Map with id "s + *map.GetId() + " already exists"s);
@@ -69,39 +366,236 @@ const Map* Game::FindMap(const Map::Id& id) const noexcept {
     return nullptr;
 }
 
-std::optional<std::reference_wrapper<const GameSessionPtr>> Game::FindSession(const Map::Id& id) const noexcept {
-    if (auto it = map_id_to_session_.find(id); it != map_id_to_session_.end()) {
-        return it->second;
+std::optional<std::reference_wrapper<const GameSessionPtr>> Game::FindSession(const Map::Id& id, size_t instance) const noexcept {
+    if (auto it = map_id_to_sessions_.find(id); it != map_id_to_sessions_.end() && instance < it->second.size()) {
+        return it->second[instance];
     }
     return std::nullopt;
 }
 
 void RoadGrid::AddRoad(const Road* road) {
-    if (road->IsHorizontal()) {
-        auto y = road->GetStart().y;
-        for (auto x = std::min(road->GetStart().x, road->GetEnd().x); x <= std::max(road->GetStart().x, road->GetEnd().x); ++x) {
-            grid_[{x, y}] = true;
+    const auto min_x = std::min(road->GetStart().x, road->GetEnd().x);
+    const auto max_x = std::max(road->GetStart().x, road->GetEnd().x);
+    const auto min_y = std::min(road->GetStart().y, road->GetEnd().y);
+    const auto max_y = std::max(road->GetStart().y, road->GetEnd().y);
+
+    Reserve(min_x >> TILE_SHIFT, min_y >> TILE_SHIFT, max_x >> TILE_SHIFT, max_y >> TILE_SHIFT);
+
+    for (auto y = min_y; y <= max_y; ++y) {
+        for (auto x = min_x; x <= max_x; ++x) {
+            SetCell(x, y);
+        }
+    }
+}
+
+void RoadGrid::Reserve(geom::Coord min_x, geom::Coord min_y, geom::Coord max_x, geom::Coord max_y) {
+    if (!directory_.empty()) {
+        if (min_x >= origin_x_ && min_y >= origin_y_ && max_x < origin_x_ + width_ && max_y < origin_y_ + height_) {
+            return;
+        }
+        min_x = std::min(min_x, origin_x_);
+        min_y = std::min(min_y, origin_y_);
+        max_x = std::max(max_x, origin_x_ + width_ - 1);
+        max_y = std::max(max_y, origin_y_ + height_ - 1);
+    }
+
+    const auto new_width = max_x - min_x + 1;
+    const auto new_height = max_y - min_y + 1;
+    std::vector<uint32_t> new_directory(static_cast<size_t>(new_width) * new_height, NO_TILE);
+
+    // Переносим уже созданные тайлы в новый каталог
+    for (geom::Coord ty = 0; ty < height_; ++ty) {
+        for (geom::Coord tx = 0; tx < width_; ++tx) {
+            const auto new_tx = tx + origin_x_ - min_x;
+            const auto new_ty = ty + origin_y_ - min_y;
+            new_directory[static_cast<size_t>(new_ty) * new_width + new_tx] = directory_[static_cast<size_t>(ty) * width_ + tx];
         }
+    }
+
+    directory_ = std::move(new_directory);
+    origin_x_ = min_x;
+    origin_y_ = min_y;
+    width_ = new_width;
+    height_ = new_height;
+}
+
+void RoadGrid::SetCell(geom::Coord x, geom::Coord y) {
+    auto& tile_idx = directory_[static_cast<size_t>((y >> TILE_SHIFT) - origin_y_) * width_ + ((x >> TILE_SHIFT) - origin_x_)];
+    if (tile_idx == NO_TILE) {
+        tile_idx = static_cast<uint32_t>(tiles_.size());
+        tiles_.emplace_back().fill(0);
+    }
+    tiles_[tile_idx][y & TILE_MASK] |= uint64_t{1} << (x & TILE_MASK);
+}
+
+void RoadGraph::AddRoad(const Road& road) {
+    const auto start = road.GetStart();
+    const auto end = road.GetEnd();
+    if (road.IsHorizontal()) {
+        horizontal_.roads[start.y].push_back({std::min(start.x, end.x), std::max(start.x, end.x)});
     } else {
-        auto x = road->GetStart().x;
-        for (auto y = std::min(road->GetStart().y, road->GetEnd().y); y <= std::max(road->GetStart().y, road->GetEnd().y); ++y) {
-            grid_[{x, y}] = true;
+        vertical_.roads[start.x].push_back({std::min(start.y, end.y), std::max(start.y, end.y)});
+    }
+}
+
+void RoadGraph::Build() {
+    BuildLines(horizontal_, vertical_);
+    BuildLines(vertical_, horizontal_);
+}
+
+void RoadGraph::BuildLines(Orientation& orientation, const Orientation& crossing) {
+    const auto by_from = [](const Segment& lhs, const Segment& rhs) {
+        return lhs.from < rhs.from;
+    };
+
+    std::vector<geom::Coord> lines;
+    lines.reserve(orientation.roads.size());
+    for (const auto& [line, _] : orientation.roads) {
+        lines.push_back(line);
+    }
+    std::sort(lines.begin(), lines.end());
+
+    // Перпендикулярная дорога добавляет клетку пересечения в каждую линию этого направления, которую пересекает
+    Lines crossing_cells;
+    for (const auto& [crossing_line, crossing_roads] : crossing.roads) {
+        for (const auto& road : crossing_roads) {
+            for (auto it = std::lower_bound(lines.begin(), lines.end(), road.from); it != lines.end() && *it <= road.to; ++it) {
+                crossing_cells[*it].push_back({crossing_line, crossing_line});
+            }
         }
     }
+
+    orientation.segments.clear();
+    for (auto& [line, roads] : orientation.roads) {
+        auto& cells = crossing_cells[line];
+        std::sort(roads.begin(), roads.end(), by_from);
+        std::sort(cells.begin(), cells.end(), by_from);
+
+        // Сливаем дороги и клетки пересечения по from, объединяя перекрывающиеся и соседние участки
+        std::vector<Segment> merged;
+        auto road_it = roads.begin();
+        auto cell_it = cells.begin();
+        while (road_it != roads.end() || cell_it != cells.end()) {
+            const bool take_road = cell_it == cells.end() || (road_it != roads.end() && road_it->from <= cell_it->from);
+            const auto& segment = take_road ? *road_it++ : *cell_it++;
+            if (!merged.empty() && segment.from <= merged.back().to + 1) {
+                merged.back().to = std::max(merged.back().to, segment.to);
+            } else {
+                merged.push_back(segment);
+            }
+        }
+        orientation.segments[line] = std::move(merged);
+    }
+}
+
+std::optional<geom::Coord> RoadGraph::FindReach(bool horizontal, geom::Coord line, geom::Coord cell, geom::Coord step) const {
+    const auto& segments = horizontal ? horizontal_.segments : vertical_.segments;
+    const auto line_it = segments.find(line);
+    if (line_it == segments.end()) {
+        return std::nullopt;
+    }
+
+    // Участок, в котором лежит следующая клетка
+    const auto next = cell + step;
+    const auto& line_segments = line_it->second;
+    auto it = std::upper_bound(line_segments.begin(), line_segments.end(), next, [](geom::Coord c, const Segment& segment) {
+        return c < segment.from;
+    });
+    if (it == line_segments.begin() || (--it)->to < next) {
+        return cell;
+    }
+    return step > 0 ? it->to : it->from;
 }
 
-bool RoadGrid::ContainsRoad(const geom::Point& p) const {
-    return grid_.find(p) != grid_.end();
+void RoadSampler::AddRoad(const Road& road) {
+    const auto start = road.GetStart();
+    const auto end = road.GetEnd();
+    lengths_.push_back(std::abs(end.x - start.x) + std::abs(end.y - start.y));
+}
+
+void RoadSampler::Build() {
+    static constexpr double full_threshold = 4294967296.0;  // 2^32: столбец всегда выбирает свою дорогу
+
+    const size_t n = lengths_.size();
+    double total = 0.0;
+    for (const auto length : lengths_) {
+        total += length;
+    }
+
+    // Доли столбцов, нормированные так, что в среднем столбец заполнен ровно на 1
+    std::vector<double> scaled(n, 1.0);
+    if (total > 0.0) {
+        for (size_t i = 0; i < n; ++i) {
+            scaled[i] = lengths_[i] * static_cast<double>(n) / total;
+        }
+    }
+
+    thresholds_.assign(n, static_cast<uint64_t>(full_threshold));
+    aliases_.resize(n);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; ++i) {
+        aliases_[i] = static_cast<uint32_t>(i);
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+    // Недозаполненный столбец добирается долей самой большой дороги, остаток которой снова распределяется.
+    // Оставшиеся в конце столбцы заполнены на 1 с точностью до округления
+    while (!small.empty() && !large.empty()) {
+        const auto s = small.back();
+        small.pop_back();
+        const auto l = large.back();
+        thresholds_[s] = static_cast<uint64_t>(scaled[s] * full_threshold);
+        aliases_[s] = l;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+}
+
+size_t RoadSampler::Sample(uint64_t bits) const noexcept {
+    assert(thresholds_.size() == lengths_.size() && !thresholds_.empty());
+    const size_t column = static_cast<size_t>(((bits >> 32) * thresholds_.size()) >> 32);
+    return (bits & 0xffffffff) < thresholds_[column] ? column : aliases_[column];
 }
 
 void Map::MoveDog(Dog* dog, std::chrono::milliseconds delta_ms) const {
+    auto pos = dog->GetPos();
+    auto vel = dog->GetVelocity();
+    if (MoveDog(pos, vel, delta_ms)) {
+        dog->SetIdle(true);
+    }
+    dog->SetPos(pos);
+    dog->SetVelocity(vel);
+}
+
+Map::Stop Map::FindStop(geom::Point2D pos, geom::Vec2D vel) const {
+    static constexpr double millis_per_second = 1000.0;
+
+    // Собака движется вдоль одной оси
+    const double speed = std::abs(vel.x) + std::abs(vel.y);
+    if (speed == 0.0) {
+        return {pos, std::chrono::milliseconds{0}};
+    }
+
+    // За это время собака с любой клетки карты гарантированно доходит до края дороги
+    const double max_distance = 2.0 * max_extent_ + 2.0;
+    const std::chrono::milliseconds long_enough{static_cast<int64_t>(std::ceil(max_distance / speed * millis_per_second))};
+    auto stop_pos = pos;
+    MoveDog(stop_pos, vel, long_enough);
+
+    const double distance = std::abs(stop_pos.x - pos.x) + std::abs(stop_pos.y - pos.y);
+    return {stop_pos, std::chrono::milliseconds{static_cast<int64_t>(std::ceil(distance / speed * millis_per_second))}};
+}
+
+bool Map::MoveDog(geom::Point2D& currentPos, geom::Vec2D& velocity, std::chrono::milliseconds delta_ms) const {
     static constexpr double allowance = 0.4;
     static constexpr double eps = 1e-6;
     static constexpr double millis_per_second = 1000.0;
 
     auto dt = delta_ms.count() / millis_per_second;
-    auto currentPos = dog->GetPos();
-    auto velocity = dog->GetVelocity();
+    const auto initial_velocity = velocity;
+    bool stopped = false;
 
     auto cell_x = static_cast<geom::Coord>(std::round(currentPos.x));
     auto cell_y = static_cast<geom::Coord>(std::round(currentPos.y));
@@ -112,7 +606,7 @@ void Map::MoveDog(Dog* dog, std::chrono::milliseconds delta_ms) const {
     const auto y_offset_out_of_range = std::abs(currentPos.y - cell_y) > allowance + eps;
     const auto x_offset_out_of_range = std::abs(currentPos.x - cell_x) > allowance + eps;
 
-    auto move_axis = [this, dog, dt](double& pos, double vel, geom::Coord& cell, bool is_on_axis, bool offset_out_of_range, geom::Coord fixed_coord, bool is_x_axis) {
+    auto move_axis = [this, &velocity, &stopped, dt](double& pos, double vel, geom::Coord& cell, bool is_on_axis, bool offset_out_of_range, geom::Coord fixed_coord, bool is_x_axis) {
         if (vel) {
             double d = vel * dt;
             auto target = pos + d;
@@ -122,11 +616,14 @@ void Map::MoveDog(Dog* dog, std::chrono::milliseconds delta_ms) const {
             const auto cant_move_along_axis = offset_out_of_range && is_on_axis;
 
             if (!cant_move_along_axis) {
-                while (cell != target_cell) {
-                    if (road_grid_.ContainsRoad({is_x_axis ? cell + step : fixed_coord, is_x_axis ? fixed_coord : cell + step})) {
+                // Идём до конца участка дороги, но не дальше целевой клетки
+                if (auto reach = road_graph_.FindReach(is_x_axis, fixed_coord, cell, step)) {
+                    cell = step > 0 ? std::min(target_cell, *reach) : std::max(target_cell, *reach);
+                } else {
+                    // На линии нет дорог этого направления - можно пройти только по соседним
+                    // параллельным перпендикулярным дорогам, таких клеток немного
+                    while (cell != target_cell && road_grid_.ContainsRoad({is_x_axis ? cell + step : fixed_coord, is_x_axis ? fixed_coord : cell + step})) {
                         cell += step;
-                    } else {
-                        break;
                     }
                 }
             }
@@ -138,8 +635,8 @@ void Map::MoveDog(Dog* dog, std::chrono::milliseconds delta_ms) const {
             const auto is_road_ahead = road_grid_.ContainsRoad({is_x_axis ? cell + diff_step : fixed_coord, is_x_axis ? fixed_coord : cell + diff_step});
 
             if (step == diff_step && (cant_move_along_axis || !is_road_ahead) && std::abs(diff) > allowance) {
-                dog->SetIdle(true);
-                dog->SetVelocity({0, 0});
+                stopped = true;
+                velocity = {0, 0};
                 diff = std::clamp(diff, -allowance, allowance);
             }
 
@@ -147,9 +644,91 @@ void Map::MoveDog(Dog* dog, std::chrono::milliseconds delta_ms) const {
         }
     };
 
-    move_axis(currentPos.x, velocity.x, cell_x, is_on_vertical, y_offset_out_of_range, cell_y, true);
-    move_axis(currentPos.y, velocity.y, cell_y, is_on_horizontal, x_offset_out_of_range, cell_x, false);
-    dog->SetPos(currentPos);
+    move_axis(currentPos.x, initial_velocity.x, cell_x, is_on_vertical, y_offset_out_of_range, cell_y, true);
+    move_axis(currentPos.y, initial_velocity.y, cell_y, is_on_horizontal, x_offset_out_of_range, cell_x, false);
+    return stopped;
+}
+
+bool Map::MoveDog(geom::FixedPoint2D& pos, geom::FixedVec2D& velocity, std::chrono::milliseconds delta_ms, int64_t& remainder) const {
+    // Допуск округлён вниз: точка сетки, лежащая дальше 0.4 от оси, должна быть вне допуска и здесь
+    static constexpr auto allowance = static_cast<geom::Fixed>(0.4 * geom::FIXED_ONE);
+    static constexpr int64_t millis_per_second = 1000;
+
+    const auto initial_velocity = velocity;
+    bool stopped = false;
+
+    auto cell_x = geom::FixedToCell(pos.x);
+    auto cell_y = geom::FixedToCell(pos.y);
+
+    const auto is_on_vertical = road_grid_.ContainsRoad({cell_x, cell_y + 1}) || road_grid_.ContainsRoad({cell_x, cell_y - 1});
+    const auto is_on_horizontal = road_grid_.ContainsRoad({cell_x + 1, cell_y}) || road_grid_.ContainsRoad({cell_x - 1, cell_y});
+
+    const auto y_offset_out_of_range = std::abs(pos.y - geom::CellToFixed(cell_y)) > allowance;
+    const auto x_offset_out_of_range = std::abs(pos.x - geom::CellToFixed(cell_x)) > allowance;
+
+    // Повторяет move_axis из MoveDog для double
+    auto move_axis = [this, &velocity, &stopped, &remainder, delta_ms](geom::Fixed& pos, geom::Fixed vel, geom::Coord& cell, bool is_on_axis, bool offset_out_of_range, geom::Coord fixed_coord, bool is_x_axis) {
+        if (vel) {
+            // Деление с остатком: сумма сдвигов за несколько шагов равна сдвигу за их общее время
+            const int64_t travel = int64_t{vel} * delta_ms.count() + remainder;
+            const auto d = static_cast<geom::Fixed>(travel / millis_per_second);
+            remainder = travel % millis_per_second;
+
+            const auto target = pos + d;
+            const auto target_cell = geom::FixedToCell(target);
+            const geom::Coord step = (vel > 0) ? 1 : -1;
+
+            const auto cant_move_along_axis = offset_out_of_range && is_on_axis;
+
+            if (!cant_move_along_axis) {
+                if (auto reach = road_graph_.FindReach(is_x_axis, fixed_coord, cell, step)) {
+                    cell = step > 0 ? std::min(target_cell, *reach) : std::max(target_cell, *reach);
+                } else {
+                    while (cell != target_cell && road_grid_.ContainsRoad({is_x_axis ? cell + step : fixed_coord, is_x_axis ? fixed_coord : cell + step})) {
+                        cell += step;
+                    }
+                }
+            }
+
+            auto diff = target - geom::CellToFixed(cell);
+            const geom::Coord diff_step = (diff > 0) ? 1 : -1;
+
+            const auto is_road_ahead = road_grid_.ContainsRoad({is_x_axis ? cell + diff_step : fixed_coord, is_x_axis ? fixed_coord : cell + diff_step});
+
+            if (step == diff_step && (cant_move_along_axis || !is_road_ahead) && std::abs(diff) > allowance) {
+                stopped = true;
+                velocity = {0, 0};
+                remainder = 0;
+                diff = std::clamp(diff, -allowance, allowance);
+            }
+
+            pos = geom::CellToFixed(cell) + diff;
+        }
+    };
+
+    move_axis(pos.x, initial_velocity.x, cell_x, is_on_vertical, y_offset_out_of_range, cell_y, true);
+    move_axis(pos.y, initial_velocity.y, cell_y, is_on_horizontal, x_offset_out_of_range, cell_x, false);
+    return stopped;
+}
+
+size_t Game::ReleaseEmptySessions(std::chrono::milliseconds dt) {
+    size_t released = 0;
+    for (auto it = map_id_to_sessions_.begin(); it != map_id_to_sessions_.end(); ) {
+        auto& sessions = it->second;
+        released += std::erase_if(sessions, [this, dt](const GameSessionPtr& session) {
+            if (session->GetDogs().Size() != 0) {
+                session->SetEmptyFor(0ms);
+                return false;
+            }
+            session->SetEmptyFor(session->GetEmptyFor() + dt);
+            return session->GetEmptyFor() >= empty_session_lifetime_;
+        });
+        for (size_t instance = 0; instance < sessions.size(); ++instance) {
+            sessions[instance]->SetInstance(instance);
+        }
+        it = sessions.empty() ? map_id_to_sessions_.erase(it) : std::next(it);
+    }
+    return released;
 }
 
 std::optional<std::reference_wrapper<const GameSessionPtr>> Game::GetSession(const Map::Id& id) {
@@ -158,10 +737,28 @@ std::optional<std::reference_wrapper<const GameSessionPtr>> Game::GetSession(con
         return std::nullopt;
     }
 
-    if (!map_id_to_session_.count(id)) {
-        map_id_to_session_.emplace(std::make_pair(id, std::make_unique<GameSession>(map, loot_gen_interval_, loot_gen_prob_)));
+    const GameSessionPtr* least_loaded = nullptr;
+    for (const auto& session : map_id_to_sessions_[id]) {
+        const auto players = session->GetDogs().Size();
+        if (max_players_per_session_ != 0 && players >= max_players_per_session_) {
+            continue;
+        }
+        if (!least_loaded || players < (*least_loaded)->GetDogs().Size()) {
+            least_loaded = &session;
+        }
+    }
+
+    if (!least_loaded) {
+        auto session = std::make_shared<GameSession>(map, loot_gen_interval_, loot_gen_prob_);
+        //номер потока не совпадает с номером экземпляра: сессия, созданная вместо освобождённой, получает новый поток
+        if (random_seed_) {
+            session->GetRandom().Seed(util::CounterRandom::DeriveSeed(*random_seed_, created_sessions_));
+        }
+        ++created_sessions_;
+        AddSession(session);
+        least_loaded = &map_id_to_sessions_.at(id).back();
     }
-    return std::cref(map_id_to_session_.at(id));
+    return std::cref(*least_loaded);
 }
 
 }  // namespace model
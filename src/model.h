@@ -5,8 +5,20 @@
 #include "extra_data.h"
 #include "loot_generator.h"
 #include "geom.h"
+#include "counter_random.h"
 
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <optional>
+#include <queue>
+#include <random>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace model {
 
@@ -105,14 +117,102 @@ private:
     geom::Offset offset_;
 };
 
+// Битовая карта клеток, занятых дорогами.
+// Ограничивающий прямоугольник карты делится на тайлы 64x64 клетки, каждая строка тайла - одно
+// 64-битное слово. Тайлы без дорог не хранятся, поэтому и большие разреженные карты занимают мало памяти.
 class RoadGrid {
 public:
-    using Grid = std::unordered_map<geom::Point, bool, geom::PointHasher>;
-
     void AddRoad(const Road* road);
-    bool ContainsRoad(const geom::Point& p) const;
+
+    bool ContainsRoad(const geom::Point& p) const noexcept {
+        const auto tile_x = (p.x >> TILE_SHIFT) - origin_x_;
+        const auto tile_y = (p.y >> TILE_SHIFT) - origin_y_;
+        if (tile_x < 0 || tile_y < 0 || tile_x >= width_ || tile_y >= height_) {
+            return false;
+        }
+        const auto tile_idx = directory_[static_cast<size_t>(tile_y) * width_ + tile_x];
+        if (tile_idx == NO_TILE) {
+            return false;
+        }
+        return (tiles_[tile_idx][p.y & TILE_MASK] >> (p.x & TILE_MASK)) & 1u;
+    }
+
+private:
+    static constexpr int TILE_SHIFT = 6;
+    static constexpr int TILE_SIZE = 1 << TILE_SHIFT;
+    static constexpr int TILE_MASK = TILE_SIZE - 1;
+    static constexpr uint32_t NO_TILE = std::numeric_limits<uint32_t>::max();
+
+    using Tile = std::array<uint64_t, TILE_SIZE>;
+
+    // Расширяет каталог тайлов так, чтобы он покрывал тайлы [min_x, max_x] x [min_y, max_y]
+    void Reserve(geom::Coord min_x, geom::Coord min_y, geom::Coord max_x, geom::Coord max_y);
+    void SetCell(geom::Coord x, geom::Coord y);
+
+    // Каталог тайлов в пределах ограничивающего прямоугольника (в координатах тайлов)
+    geom::Coord origin_x_{0};
+    geom::Coord origin_y_{0};
+    geom::Coord width_{0};
+    geom::Coord height_{0};
+    std::vector<uint32_t> directory_;
+    std::vector<Tile> tiles_;
+};
+
+// Граф дорог: коллинеарные дороги, лежащие на одной линии, объединены в сплошные участки.
+// Клетки пересечения с перпендикулярными дорогами входят в участок линии, поэтому участок
+// совпадает с непрерывной цепочкой клеток RoadGrid вдоль этой линии.
+class RoadGraph {
+public:
+    // Участок [from, to] (from <= to) на горизонтальной (y = const) или вертикальной (x = const) линии
+    struct Segment {
+        geom::Coord from;
+        geom::Coord to;
+    };
+
+    // Запоминает дорогу. Участки строит Build
+    void AddRoad(const Road& road);
+
+    // Строит участки всех линий, когда добавлены все дороги карты. Каждая линия собирается
+    // слиянием её дорог и клеток пересечения, отсортированных по координате
+    void Build();
+
+    // Самая дальняя клетка, до которой можно пройти от cell по линии line шагами step (+1 или -1),
+    // не покидая дорог. Если соседняя клетка не дорога, возвращается сама cell.
+    // std::nullopt - на этой линии нет ни одной дороги такого же направления
+    std::optional<geom::Coord> FindReach(bool horizontal, geom::Coord line, geom::Coord cell, geom::Coord step) const;
+
+private:
+    using Lines = std::unordered_map<geom::Coord, std::vector<Segment>>;
+
+    struct Orientation {
+        Lines roads;     // дороги этого направления, как они заданы в карте
+        Lines segments;  // объединённые участки, отсортированы по from
+    };
+
+    static void BuildLines(Orientation& orientation, const Orientation& crossing);
+
+    Orientation horizontal_;
+    Orientation vertical_;
+};
+
+// Выбор случайной дороги с вероятностью, пропорциональной её длине, за O(1) (alias-метод Уокера).
+// Таблица строится один раз вызовом Build, когда добавлены все дороги карты
+class RoadSampler {
+public:
+    void AddRoad(const Road& road);
+
+    // Строит таблицу по добавленным дорогам за O(n)
+    void Build();
+
+    // Индекс дороги по 64 случайным битам: старшие 32 выбирают столбец таблицы, младшие - сам столбец или его alias.
+    // Если все дороги нулевой длины, дорога выбирается равновероятно. Таблица должна быть построена
+    size_t Sample(uint64_t bits) const noexcept;
+
 private:
-    Grid grid_;
+    std::vector<geom::Coord> lengths_;
+    // Порог для младших 32 бит (0..2^32) и дорога, выбираемая при его превышении
+    std::vector<uint64_t> thresholds_;
+    std::vector<uint32_t> aliases_;
 };
 
 class Dog {
@@ -222,8 +322,275 @@ private:
     static size_t id_counter_;
 };
 
-using DogPtr = std::shared_ptr<Dog>;
-using ConstDogPtr = std::shared_ptr<const Dog>;
+class DogRef;
+
+// Собаки игровой сессии, хранящиеся по столбцам (structure of arrays).
+// Горячие поля симуляции (позиция, скорость, направление) лежат в плотных массивах,
+// поэтому тик обходит их последовательно, не прыгая по куче.
+// Возраст и время простоя хранятся как моменты времени сессии и вычисляются при обращении,
+// а тику нужны только движущиеся собаки из GetActive(), поэтому стоящие собаки ничего не стоят.
+// Слот собаки меняется при удалении других собак, для долговременной ссылки на собаку используется её id
+class DogTable {
+public:
+    using Slot = size_t;
+    using BagItem = std::pair<size_t, size_t>;
+
+    size_t Size() const noexcept {
+        return ids_.size();
+    }
+
+    Slot Add(const Dog& dog);
+    // Удаляет собаку, перемещая на её место последнюю
+    bool Remove(size_t dog_id);
+    std::optional<Slot> FindSlot(size_t dog_id) const;
+
+    DogRef operator[](Slot slot) noexcept;
+
+    // Собака в виде отдельного объекта, например для сериализации
+    Dog Extract(Slot slot) const;
+
+    size_t GetId(Slot slot) const noexcept {
+        return ids_[slot];
+    }
+
+    std::string_view GetName(Slot slot) const noexcept {
+        return names_[slot];
+    }
+
+    std::span<const BagItem> GetBag(Slot slot) const noexcept {
+        return {bag_items_.data() + slot * bag_stride_, bag_sizes_[slot]};
+    }
+
+    // Плотные столбцы для циклов симуляции.
+    // Столбец позиций не учитывает траекторий кинетического движения: у собаки с траекторией в нём
+    // начало траектории. Читать позиции нужно через GetPos, а столбец - только у собак без траектории
+    std::span<geom::Point2D> GetPositions() noexcept {
+        return positions_;
+    }
+    std::span<const geom::Point2D> GetPositions() const noexcept {
+        return positions_;
+    }
+    std::span<geom::Vec2D> GetVelocities() noexcept {
+        return velocities_;
+    }
+    std::span<const geom::Vec2D> GetVelocities() const noexcept {
+        return velocities_;
+    }
+    // Накопленные остатки пути для движения в фиксированной точке, сбрасываются при смене скорости
+    std::span<int64_t> GetMoveRemainders() noexcept {
+        return move_remainders_;
+    }
+    std::span<const int64_t> GetMoveRemainders() const noexcept {
+        return move_remainders_;
+    }
+
+    // Слоты движущихся (не простаивающих) собак в произвольном порядке
+    std::span<const Slot> GetActive() const noexcept {
+        return active_;
+    }
+
+    // Время сессии - сумма шагов симуляции, от него отсчитываются возраст и простой собак
+    std::chrono::milliseconds GetTime() const noexcept {
+        return now_;
+    }
+
+    void AdvanceTime(std::chrono::milliseconds dt) noexcept {
+        now_ += dt;
+    }
+
+    std::chrono::milliseconds GetAge(Slot slot) const noexcept {
+        return now_ - joined_at_[slot];
+    }
+
+    std::chrono::milliseconds GetIdleFor(Slot slot) const noexcept {
+        return idle_[slot] ? now_ - idle_since_[slot] : std::chrono::milliseconds{0};
+    }
+
+    // Переводит собаку в простой или выводит из него, обновляя множество движущихся собак
+    void SetIdle(Slot slot, bool idle);
+
+    // Дописывает в out id собак, простаивающих не меньше max_idle.
+    // Каждая собака попадает в out один раз за период простоя
+    void CollectExpired(std::chrono::milliseconds max_idle, std::vector<size_t>& out);
+
+    // Кинетическое движение: собака с траекторией идёт с постоянной скоростью от positions_[slot]
+    // и через заданное время останавливается в stop_pos. Её позиция вычисляется по времени сессии,
+    // а столбец позиций обновляется только при остановке или смене скорости
+
+    bool HasTrajectory(Slot slot) const noexcept {
+        return stop_at_[slot] != NO_TRAJECTORY;
+    }
+
+    // Траектория начинается в текущий момент времени сессии
+    void SetTrajectory(Slot slot, geom::Point2D stop_pos, std::chrono::milliseconds travel_time);
+
+    // Позиция собаки в момент времени сессии t, не раньше начала траектории
+    geom::Point2D GetPosAt(Slot slot, std::chrono::milliseconds t) const noexcept;
+
+    geom::Point2D GetPos(Slot slot) const noexcept {
+        return GetPosAt(slot, now_);
+    }
+
+    // Записывает текущую позицию собаки в столбец позиций и снимает траекторию
+    void Materialize(Slot slot) noexcept;
+
+    // Останавливает собак, дошедших к текущему моменту до конца траектории, и дописывает их слоты в out.
+    // Простой собак отсчитывается от момента остановки, а не от текущего времени
+    void CollectStops(std::vector<Slot>& out);
+
+private:
+    friend class DogRef;
+
+    static constexpr size_t NOT_ACTIVE = std::numeric_limits<size_t>::max();
+    static constexpr std::chrono::milliseconds NO_TRAJECTORY = std::chrono::milliseconds::max();
+
+    // Увеличивает число ячеек рюкзака на собаку
+    void ResizeBags(size_t stride);
+    void Activate(Slot slot);
+    void Deactivate(Slot slot);
+    // Переводит движущуюся собаку в простой, начавшийся в момент since
+    void StartIdle(Slot slot, std::chrono::milliseconds since);
+
+    std::vector<size_t> ids_;
+    std::vector<geom::Point2D> positions_;
+    std::vector<geom::Vec2D> velocities_;
+    std::vector<int64_t> move_remainders_;
+    std::vector<Direction> directions_;
+    std::vector<uint8_t> idle_;
+    // Моменты времени сессии, в которые возраст и время простоя собаки были нулевыми
+    std::vector<std::chrono::milliseconds> joined_at_;
+    std::vector<std::chrono::milliseconds> idle_since_;
+    // Траектории: начало, момент и точка остановки (NO_TRAJECTORY - собака без траектории)
+    std::vector<std::chrono::milliseconds> moved_at_;
+    std::vector<std::chrono::milliseconds> stop_at_;
+    std::vector<geom::Point2D> stop_pos_;
+    std::vector<size_t> scores_;
+    std::vector<std::string> names_;
+
+    // Рюкзаки: у каждой собаки bag_stride_ ячеек подряд, занято bag_sizes_[slot] из них
+    size_t bag_stride_{0};
+    std::vector<BagItem> bag_items_;
+    std::vector<size_t> bag_sizes_;
+    std::vector<size_t> bag_capacities_;
+
+    std::unordered_map<size_t, Slot> id_to_slot_;
+
+    std::chrono::milliseconds now_{0};
+
+    // Движущиеся собаки и позиция каждой собаки в active_ (NOT_ACTIVE для простаивающих)
+    std::vector<Slot> active_;
+    std::vector<size_t> active_pos_;
+
+    // Начала простоя собак, самое раннее сверху. Записи, устаревшие из-за ухода собаки
+    // или смены её простоя, отбрасываются при извлечении
+    using IdleEntry = std::pair<std::chrono::milliseconds, size_t>;
+    std::priority_queue<IdleEntry, std::vector<IdleEntry>, std::greater<>> idle_queue_;
+
+    // Моменты остановки собак с траекториями, самый ранний сверху. Устаревшие записи отбрасываются так же
+    using StopEntry = std::pair<std::chrono::milliseconds, size_t>;
+    std::priority_queue<StopEntry, std::vector<StopEntry>, std::greater<>> stop_queue_;
+};
+
+// Лёгкая ссылка на собаку в DogTable с тем же интерфейсом, что у Dog.
+// Действительна до ближайшего добавления или удаления собак, хранить её нельзя
+class DogRef {
+public:
+    DogRef(DogTable& dogs, DogTable::Slot slot) noexcept
+        : dogs_{&dogs}
+        , slot_{slot} {
+    }
+
+    DogTable::Slot GetSlot() const noexcept {
+        return slot_;
+    }
+
+    size_t GetId() const noexcept {
+        return dogs_->ids_[slot_];
+    }
+
+    std::string_view GetName() const noexcept {
+        return dogs_->names_[slot_];
+    }
+
+    geom::Point2D GetPos() const noexcept {
+        return dogs_->GetPos(slot_);
+    }
+
+    void SetPos(const geom::Point2D& pos) const {
+        dogs_->Materialize(slot_);
+        dogs_->positions_[slot_] = pos;
+    }
+
+    const geom::Vec2D& GetVelocity() const noexcept {
+        return dogs_->velocities_[slot_];
+    }
+
+    void SetVelocity(const geom::Vec2D& vel) const {
+        dogs_->Materialize(slot_);
+        dogs_->velocities_[slot_] = vel;
+        dogs_->move_remainders_[slot_] = 0;
+    }
+
+    Direction GetDir() const noexcept {
+        return dogs_->directions_[slot_];
+    }
+
+    void SetDir(Direction dir) const {
+        dogs_->directions_[slot_] = dir;
+    }
+
+    bool TryGrabItem(size_t id, size_t type) const;
+
+    std::span<const DogTable::BagItem> GetBag() const noexcept {
+        return dogs_->GetBag(slot_);
+    }
+
+    void ClearBag() const {
+        dogs_->bag_sizes_[slot_] = 0;
+    }
+
+    size_t GetBagCapacity() const noexcept {
+        return dogs_->bag_capacities_[slot_];
+    }
+
+    size_t GetScore() const noexcept {
+        return dogs_->scores_[slot_];
+    }
+
+    void SetScore(size_t score) const {
+        dogs_->scores_[slot_] = score;
+    }
+
+    std::chrono::milliseconds GetAge() const noexcept {
+        return dogs_->GetAge(slot_);
+    }
+
+    void SetAge(std::chrono::milliseconds age) const {
+        dogs_->joined_at_[slot_] = dogs_->now_ - age;
+    }
+
+    std::chrono::milliseconds GetIdleFor() const noexcept {
+        return dogs_->GetIdleFor(slot_);
+    }
+
+    void SetIdleFor(std::chrono::milliseconds idle_for) const;
+
+    bool IsIdle() const noexcept {
+        return dogs_->idle_[slot_];
+    }
+
+    void SetIdle(bool idle = true) const {
+        dogs_->SetIdle(slot_, idle);
+    }
+
+private:
+    DogTable* dogs_;
+    DogTable::Slot slot_;
+};
+
+inline DogRef DogTable::operator[](Slot slot) noexcept {
+    return {*this, slot};
+}
 
 class RetiredDog {
 public:
@@ -269,7 +636,7 @@ protected:
 class Map {
 public:
     using Id = util::Tagged<std::string, Map>;
-    using Roads = std::vector<std::unique_ptr<Road>>;
+    using Roads = std::vector<Road>;
     using Buildings = std::vector<Building>;
     using Offices = std::vector<Office>;
 
@@ -305,7 +672,17 @@ public:
         return offices_;
     }
 
-    void AddRoad(std::unique_ptr<Road> road);
+    void AddRoad(const Road& road);
+
+    // Готовит выбор случайных точек после добавления всех дорог. Game::AddMap вызывает его сам
+    void BuildRoadSampler() {
+        road_sampler_.Build();
+    }
+
+    // Объединяет дороги в участки для MoveDog после добавления всех дорог. Game::AddMap вызывает его сам
+    void BuildRoadGraph() {
+        road_graph_.Build();
+    }
 
     void AddBuilding(const Building& building) {
         buildings_.emplace_back(building);
@@ -317,6 +694,14 @@ public:
         return road_grid_;
     }
 
+    const RoadGraph& GetRoadGraph() const noexcept {
+        return road_graph_;
+    }
+
+    // Случайная точка на дорогах карты, распределённая равномерно по их суммарной длине.
+    // Требует вызова BuildRoadSampler
+    geom::Point2D GetRandomPoint(util::CounterRandom& random) const;
+
     const ExtraData& GetExtraData() const noexcept {
         return extra_data_;
     }
@@ -329,6 +714,21 @@ public:
         return bag_capacity_;
     }
 
+    // Перемещает собаку вдоль дорог. Возвращает true, если собака упёрлась в край дороги
+    // и остановилась (скорость при этом обнуляется)
+    bool MoveDog(geom::Point2D& pos, geom::Vec2D& vel, std::chrono::milliseconds delta_ms) const;
+
+    // То же в фиксированной точке, только целочисленная арифметика. Доли единицы пути, не набравшиеся за шаг,
+    // копятся в remainder (в тысячных долях единицы), поэтому путь не зависит от того, как время разбито на шаги
+    bool MoveDog(geom::FixedPoint2D& pos, geom::FixedVec2D& vel, std::chrono::milliseconds delta_ms, int64_t& remainder) const;
+
+    // Где и через сколько остановится собака, если её не трогать. Время округляется вверх до миллисекунды
+    struct Stop {
+        geom::Point2D pos;
+        std::chrono::milliseconds after;
+    };
+    Stop FindStop(geom::Point2D pos, geom::Vec2D vel) const;
+
     void MoveDog(Dog* dog, std::chrono::milliseconds delta_ms) const;
 
 private:
@@ -345,12 +745,49 @@ private:
     double dog_speed_;
 
     RoadGrid road_grid_;
+    RoadGraph road_graph_;
+    RoadSampler road_sampler_;
+    // Наибольший модуль координаты концов дорог
+    geom::Coord max_extent_{0};
 
     ExtraData extra_data_;
 
     size_t bag_capacity_;
 };
 
+// Пространственный индекс трофеев сессии: id трофеев разложены по квадратным ячейкам.
+// Обновляется при появлении и подборе трофея, поэтому тику не нужно перебирать все трофеи карты,
+// достаточно опросить ячейки рядом с движущимися собаками
+class LootIndex {
+public:
+    static constexpr double CELL_SIZE = 4.0;
+
+    void Add(size_t loot_id, geom::Point2D pos);
+    void Remove(size_t loot_id, geom::Point2D pos);
+
+    // Дописывает в out id трофеев из ячеек, пересекающих прямоугольник [min, max].
+    // Трофеи из этих ячеек могут лежать вне прямоугольника
+    void Query(geom::Point2D min, geom::Point2D max, std::vector<size_t>& out) const;
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+private:
+    using CellKey = uint64_t;
+
+    static int32_t ToCell(double coord) noexcept {
+        return static_cast<int32_t>(std::floor(coord / CELL_SIZE));
+    }
+
+    static CellKey MakeKey(int32_t x, int32_t y) noexcept {
+        return (static_cast<CellKey>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    std::unordered_map<CellKey, std::vector<size_t>> cells_;
+    size_t size_{0};
+};
+
 class GameSession {
 public:
     GameSession() = delete;
@@ -359,36 +796,39 @@ public:
                          : map_{map}
                          , loot_gen_{period, prob} {}
 
-    const DogPtr& CreateDog(std::string_view name, geom::Point2D pos);
+    DogRef CreateDog(std::string_view name, geom::Point2D pos);
 
-    const auto& GetDogs() const noexcept {
+    const DogTable& GetDogs() const noexcept {
         return dogs_;
     }
 
-    auto& GetDogs() {
+    DogTable& GetDogs() {
         return dogs_;
     }
 
-    void AddDog(const DogPtr& dog) {
-        dogs_.emplace(dog->GetId(), dog);
+    DogRef AddDog(const Dog& dog) {
+        BumpVersion();
+        return dogs_[dogs_.Add(dog)];
     }
 
     bool RemoveDog(size_t dog_id) {
-        return dogs_.erase(dog_id) != 0;
+        BumpVersion();
+        return dogs_.Remove(dog_id);
     }
 
-    std::optional<std::reference_wrapper<const DogPtr>> GetDogById(size_t id) const;
+    std::optional<DogRef> GetDogById(size_t id);
 
     const Map* GetMap() const noexcept {
         return map_;
     }
 
-    auto& GetLoot() {
+    // Трофеи меняются только через AddLoot и RemoveLoot, чтобы индекс не расходился с ними
+    const auto& GetLoot() const noexcept {
         return loot_map_;
     }
 
-    auto& GetLoot() const {
-        return loot_map_;
+    const LootIndex& GetLootIndex() const noexcept {
+        return loot_index_;
     }
 
     auto& GetLootGenerator() const noexcept {
@@ -398,16 +838,12 @@ public:
         return loot_gen_;
     }
 
-    void AddLoot(std::pair<size_t, geom::Point2D> loot, size_t id = 0) {
-        loot_map_.emplace(id == 0 ? ++loot_id_: id, std::move(loot));
-    }
+    void AddLoot(std::pair<size_t, geom::Point2D> loot, size_t id = 0);
 
-    void RemoveLoot(size_t idx) {
-        loot_map_.erase(idx);
-    }
+    void RemoveLoot(size_t idx);
 
     size_t GenerateLoot(std::chrono::milliseconds dt) {
-        return loot_gen_.Generate(dt, loot_map_.size(), dogs_.size());
+        return loot_gen_.Generate(dt, loot_map_.size(), dogs_.Size());
     }
 
     auto GetNextLootId() const noexcept {
@@ -418,12 +854,71 @@ public:
         loot_id_ = id;
     }
 
+    // У каждой сессии свой поток случайных чисел, чтобы сессии можно было тикать параллельно.
+    // Из него берутся места появления собак и трофеев и типы трофеев: при том же зерне они повторяются
+    util::CounterRandom& GetRandom() noexcept {
+        return random_;
+    }
+
+    const util::CounterRandom& GetRandom() const noexcept {
+        return random_;
+    }
+
+    // Собаки, простоявшие дольше допустимого и ожидающие отправки на пенсию.
+    // Пополняется тиком из DogTable::CollectExpired
+    std::vector<size_t>& GetExpiredDogs() noexcept {
+        return expired_dogs_;
+    }
+
+    // Номер экземпляра среди сессий той же карты
+    size_t GetInstance() const noexcept {
+        return instance_;
+    }
+
+    void SetInstance(size_t instance) {
+        instance_ = instance;
+    }
+
+    // Сколько времени подряд в сессии нет ни одной собаки. Считает Game::ReleaseEmptySessions
+    auto GetEmptyFor() const noexcept {
+        return empty_for_;
+    }
+
+    void SetEmptyFor(std::chrono::milliseconds empty_for) {
+        empty_for_ = empty_for;
+    }
+
+    // Версия состояния сессии. Растёт с каждым тиком и с каждым изменением между тиками
+    // (вход и уход собаки, смена направления), клиентам отдаётся как ETag
+    uint64_t GetVersion() const noexcept {
+        return version_;
+    }
+
+    // Номер сессии, уникальный в пределах процесса. Версия не сохраняется вместе с игрой и у разных сессий
+    // совпадает, поэтому ETag состояния строится из номера сессии и версии
+    uint64_t GetUid() const noexcept {
+        return uid_;
+    }
+
+    void BumpVersion() noexcept {
+        ++version_;
+    }
+
 private:
     const Map* map_;
-    std::unordered_map<size_t, DogPtr> dogs_;
+    DogTable dogs_;
     std::unordered_map<size_t, std::pair<size_t, geom::Point2D>> loot_map_;
+    LootIndex loot_index_;
     loot_gen::LootGenerator loot_gen_;
     size_t loot_id_{0};
+    util::CounterRandom random_{(static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}()};
+    size_t instance_{0};
+    std::chrono::milliseconds empty_for_{0};
+    std::vector<size_t> expired_dogs_;
+    uint64_t version_{0};
+    const uint64_t uid_{next_uid_++};
+
+    static std::atomic<uint64_t> next_uid_;
 };
 
 using GameSessionPtr = std::shared_ptr<GameSession>;
@@ -431,28 +926,29 @@ using ConstGameSessionPtr = std::shared_ptr<const GameSession>;
 
 class Player {
 public:
-    Player(const GameSessionPtr& session, const DogPtr& dog)
+    Player(const GameSessionPtr& session, size_t dog_id)
                                     : session_{session}
-                                    , dog_{dog} {}
+                                    , dog_id_{dog_id} {}
 
     auto GetId() const noexcept {
-        return dog_->GetId();
+        return dog_id_;
     }
 
-    auto GetName() const {
-        return dog_->GetName();
+    std::string_view GetName() const {
+        return GetDog().GetName();
     }
 
     auto& GetSession() const {
         return session_;
     }
 
-    auto& GetDog() const {
-        return dog_;
+    // Собака игрока; ссылку нельзя хранить дольше текущей операции
+    DogRef GetDog() const {
+        return session_->GetDogById(dog_id_).value();
     }
 private:
     GameSessionPtr session_;
-    DogPtr dog_;
+    size_t dog_id_;
 };
 
 using PlayerPtr = std::shared_ptr<Player>;
@@ -476,16 +972,36 @@ public:
 
     const Map* FindMap(const Map::Id& id) const noexcept;
 
-    std::optional<std::reference_wrapper<const GameSessionPtr>> FindSession(const Map::Id& id) const noexcept;
+    // Экземпляр сессии карты с номером instance
+    std::optional<std::reference_wrapper<const GameSessionPtr>> FindSession(const Map::Id& id, size_t instance) const noexcept;
 
+    // Наименее загруженный экземпляр сессии карты, в котором есть место для ещё одного игрока.
+    // Если все экземпляры заполнены, создаётся новый
     std::optional<std::reference_wrapper<const GameSessionPtr>> GetSession(const Map::Id& id);
 
+    // Учитывает dt пустования сессий без собак и освобождает те, что пустуют не меньше GetEmptySessionLifetime.
+    // Номера оставшихся экземпляров карты сдвигаются, чтобы совпадать с их местом в списке.
+    // Следующий вход на карту при необходимости создаст сессию заново. Возвращает число освобождённых сессий
+    size_t ReleaseEmptySessions(std::chrono::milliseconds dt);
+
+    // Добавляет сессию последним экземпляром её карты
     void AddSession(const GameSessionPtr& session) {
-        map_id_to_session_.emplace(session->GetMap()->GetId(), session);
+        auto& sessions = map_id_to_sessions_[session->GetMap()->GetId()];
+        session->SetInstance(sessions.size());
+        sessions.push_back(session);
     }
 
     const auto& GetSessions() const noexcept {
-        return map_id_to_session_;
+        return map_id_to_sessions_;
+    }
+
+    // Максимальное число игроков в одном экземпляре сессии, 0 - без ограничений
+    void SetMaxPlayersPerSession(size_t max_players) {
+        max_players_per_session_ = max_players;
+    }
+
+    auto GetMaxPlayersPerSession() const noexcept {
+        return max_players_per_session_;
     }
 
     void SetDefaultDogSpeed(double speed) {
@@ -527,6 +1043,35 @@ public:
     void SetMaxIdleTime(std::chrono::milliseconds max_idle_time) {
         max_idle_time_ = max_idle_time;
     }
+
+    // Сколько сессия без собак живёт до освобождения. Пока она жива, тик её пропускает
+    auto GetEmptySessionLifetime() const noexcept {
+        return empty_session_lifetime_;
+    }
+
+    void SetEmptySessionLifetime(std::chrono::milliseconds lifetime) {
+        empty_session_lifetime_ = lifetime;
+    }
+
+    // Общее зерно случайных потоков. Новые сессии получают зерно, производное от него и порядкового номера создания,
+    // поэтому игру можно воспроизвести. Без общего зерна потоки сессий начинаются со случайного
+    void SetRandomSeed(std::optional<uint64_t> seed) {
+        random_seed_ = seed;
+    }
+
+    auto GetRandomSeed() const noexcept {
+        return random_seed_;
+    }
+
+    // Номер случайного потока следующей созданной сессии. Сохраняется вместе с игрой,
+    // чтобы после восстановления новые сессии не повторяли потоки прежних
+    auto GetCreatedSessions() const noexcept {
+        return created_sessions_;
+    }
+
+    void SetCreatedSessions(uint64_t created_sessions) {
+        created_sessions_ = created_sessions;
+    }
 private:
     using MapIdHasher = util::TaggedHasher<Map::Id>;
     using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher>;
@@ -534,8 +1079,9 @@ private:
     std::vector<Map> maps_;
     MapIdToIndex map_id_to_index_;
 
-    using MapIdToSession = std::unordered_map<Map::Id, GameSessionPtr, MapIdHasher>;
-    MapIdToSession map_id_to_session_;
+    using MapIdToSessions = std::unordered_map<Map::Id, std::vector<GameSessionPtr>, MapIdHasher>;
+    MapIdToSessions map_id_to_sessions_;
+    size_t max_players_per_session_{0};
 
     double default_dog_speed_{1.0};
 
@@ -545,6 +1091,10 @@ private:
     size_t default_bag_capacity_{3};
 
     std::chrono::milliseconds max_idle_time_{60000};
+    std::chrono::milliseconds empty_session_lifetime_{60000};
+    std::optional<uint64_t> random_seed_;
+    // Сколько сессий создано GetSession, номер случайного потока следующей
+    uint64_t created_sessions_{0};
 };
 
 }  // namespace model
@@ -1,5 +1,7 @@
 #include "model_serialization.h"
 
+#include <algorithm>
+
 namespace serialization {
 
 // DogRepr (DogRepresentation) - сериализованное представление класса Dog
@@ -46,10 +48,16 @@ GameSessionRepr::GameSessionRepr(const model::GameSession& game_session)
     : map_id_(*game_session.GetMap()->GetId())
     , loot_map_repr_(game_session.GetLoot())
     , loot_gen_repr_(game_session.GetLootGenerator())
-    , loot_id_(game_session.GetNextLootId()) {
-        for(const auto& [dog_id, dog] : game_session.GetDogs()) {
-            dogs_repr_.emplace_back(*dog);
+    , loot_id_(game_session.GetNextLootId())
+    , random_seed_(game_session.GetRandom().GetSeed())
+    , random_counter_(game_session.GetRandom().GetCounter())
+    , has_random_(true) {
+        const auto& dogs = game_session.GetDogs();
+        for(model::DogTable::Slot slot = 0; slot < dogs.Size(); ++slot) {
+            dogs_repr_.emplace_back(dogs.Extract(slot));
         }
+        const auto remainders = dogs.GetMoveRemainders();
+        move_remainders_.assign(remainders.begin(), remainders.end());
 }
 
 model::GameSession GameSessionRepr::Restore(const app::Application& app) const {
@@ -59,21 +67,32 @@ model::GameSession GameSessionRepr::Restore(const app::Application& app) const {
         throw std::runtime_error("Map not found");
     }
     model::GameSession game_session(map, game.GetLootGenInterval(), game.GetLootGenProbability());
-    for (const auto& dog_repr : dogs_repr_) {
-        game_session.AddDog(std::make_shared<model::Dog>(dog_repr.Restore()));
+    for (size_t i = 0; i < dogs_repr_.size(); ++i) {
+        auto dog = game_session.AddDog(dogs_repr_[i].Restore());
+        if (i < move_remainders_.size()) {
+            game_session.GetDogs().GetMoveRemainders()[dog.GetSlot()] = move_remainders_[i];
+        }
     }
     for (const auto& [id, loot] : loot_map_repr_) {
         game_session.AddLoot(loot, id);
     }
     loot_gen_repr_.Restore(game_session);
     game_session.SetNextLootId(loot_id_);
+    if (has_random_) {
+        game_session.GetRandom().Seed(random_seed_);
+        game_session.GetRandom().SetCounter(random_counter_);
+    }
     return game_session;
 }
 
 // GameRepr
-GameRepr::GameRepr(const model::Game& game) {
-    for (const auto& [map_id, session] : game.GetSessions()) {
-        sessions_repr_.emplace_back(*session);
+GameRepr::GameRepr(const model::Game& game)
+    : created_sessions_(game.GetCreatedSessions()) {
+    //экземпляры одной карты идут подряд в порядке номеров, поэтому при восстановлении номера сохраняются
+    for (const auto& [map_id, sessions] : game.GetSessions()) {
+        for (const auto& session : sessions) {
+            sessions_repr_.emplace_back(*session);
+        }
     }
 }
 
@@ -82,27 +101,27 @@ void GameRepr::Restore(app::Application& app) const {
     for (const auto& session_repr : sessions_repr_) {
         game.AddSession(std::make_shared<model::GameSession>(session_repr.Restore(app)));
     }
+    game.SetCreatedSessions(std::max<uint64_t>(created_sessions_, sessions_repr_.size()));
 }
 
 // PlayerRepr
 PlayerRepr::PlayerRepr(const model::Player& player)
     : session_id_(*player.GetSession()->GetMap()->GetId())
-    , dog_id_(player.GetDog()->GetId()) {
+    , session_instance_(player.GetSession()->GetInstance())
+    , dog_id_(player.GetId()) {
 }
 
 model::Player PlayerRepr::Restore(app::Application& app) const {
     auto& game = app.GetGame();
-    auto session_opt = game.FindSession(model::Map::Id{session_id_});
+    auto session_opt = game.FindSession(model::Map::Id{session_id_}, session_instance_);
     if (!session_opt) {
         throw std::runtime_error("Session not found");
     }
     auto& session = session_opt.value().get();
-    auto dog_opt = session->GetDogById(dog_id_);
-    if (!dog_opt) {
+    if (!session->GetDogById(dog_id_)) {
         throw std::runtime_error("Dog not found");
     }
-    auto& dog = dog_opt.value().get();
-    return model::Player(session, dog);
+    return model::Player(session, dog_id_);
 }
 
 // PlayersRepr
@@ -6,6 +6,7 @@
 #include <boost/serialization/unordered_map.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/utility.hpp>
+#include <boost/serialization/version.hpp>
 
 #include <vector>
 
@@ -97,14 +98,28 @@ public:
         ar& loot_map_repr_;
         ar& loot_gen_repr_;
         ar& loot_id_;
+        // в файлах состояния версии 0 поток случайных чисел не сохранялся, сессия начинает новый
+        if (version > 0) {
+            ar& random_seed_;
+            ar& random_counter_;
+            has_random_ = true;
+        }
+        // остатки пути движения в фиксированной точке, по одному на собаку из dogs_repr_. До версии 2 не сохранялись
+        if (version > 1) {
+            ar& move_remainders_;
+        }
     }
 
 private:
     std::string map_id_;
     std::vector<DogRepr> dogs_repr_;
+    std::vector<int64_t> move_remainders_;
     std::unordered_map<size_t, std::pair<size_t, geom::Point2D>> loot_map_repr_;
     LootGeneratorRepr loot_gen_repr_;
     size_t loot_id_{0};
+    uint64_t random_seed_{0};
+    uint64_t random_counter_{0};
+    bool has_random_{false};
 };
 
 class GameRepr {
@@ -118,10 +133,15 @@ public:
     template <typename Archive>
     void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
         ar& sessions_repr_;
+        // в файлах состояния версии 0 счётчика нет, номера потоков продолжаются после восстановленных сессий
+        if (version > 0) {
+            ar& created_sessions_;
+        }
     }
 
 private:
     std::vector<GameSessionRepr> sessions_repr_;
+    uint64_t created_sessions_{0};
 };
 
 class PlayerRepr {
@@ -136,10 +156,15 @@ public:
     void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
         ar& session_id_;
         ar& dog_id_;
+        // в файлах состояния версии 0 у каждой карты была ровно одна сессия
+        if (version > 0) {
+            ar& session_instance_;
+        }
     }
 
 private:
     std::string session_id_;
+    size_t session_instance_{0};
     size_t dog_id_{0};
 };
 
@@ -201,3 +226,7 @@ private:
 /* Другие классы модели сериализуются и десериализуются похожим образом */
 
 }  // namespace serialization
+
+BOOST_CLASS_VERSION(::serialization::PlayerRepr, 1)
+BOOST_CLASS_VERSION(::serialization::GameSessionRepr, 2)
+BOOST_CLASS_VERSION(::serialization::GameRepr, 1)
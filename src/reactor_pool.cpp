@@ -0,0 +1,59 @@
+#include "reactor_pool.h"
+
+#include <algorithm>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace util {
+
+namespace {
+
+void PinCurrentThread([[maybe_unused]] unsigned index) {
+#ifdef __linux__
+    const auto cores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(index % cores, &cpus);
+    // Привязка - только подсказка для производительности, при ошибке поток просто остаётся где был
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+}
+
+}  // namespace
+
+ReactorPool::ReactorPool(unsigned count) {
+    count = std::max(1u, count);
+    reactors_.reserve(count);
+    for (unsigned i = 0; i < count; ++i) {
+        // Подсказка планировщику: io_context выполняется ровно в одном потоке
+        reactors_.push_back(std::make_unique<boost::asio::io_context>(1));
+    }
+}
+
+void ReactorPool::Run(bool pin_threads) {
+    const auto run = [this, pin_threads](unsigned index) {
+        if (pin_threads) {
+            PinCurrentThread(index);
+        }
+        reactors_[index]->run();
+    };
+
+    std::vector<std::jthread> threads;
+    threads.reserve(reactors_.size() - 1);
+    for (unsigned i = 1; i < reactors_.size(); ++i) {
+        threads.emplace_back(run, i);
+    }
+    run(0);
+}
+
+void ReactorPool::Stop() {
+    for (auto& reactor : reactors_) {
+        reactor->stop();
+    }
+}
+
+}  // namespace util
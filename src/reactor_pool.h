@@ -0,0 +1,39 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace util {
+
+// Набор независимых io_context, по одному на поток. Каждый поток разбирает только свою очередь
+// и не делит блокировки планировщика с другими, поэтому асинхронные операции не ходят между потоками.
+// Работа, которую нужно выполнять в одном месте (состояние игры), отправляется в чужой strand явно
+class ReactorPool {
+public:
+    explicit ReactorPool(unsigned count);
+
+    ReactorPool(const ReactorPool&) = delete;
+    ReactorPool& operator=(const ReactorPool&) = delete;
+
+    size_t Size() const noexcept {
+        return reactors_.size();
+    }
+
+    boost::asio::io_context& operator[](size_t index) noexcept {
+        return *reactors_[index];
+    }
+
+    // Выполняет каждый io_context в своём потоке, один из них - в вызывающем, и ждёт, пока все не остановятся.
+    // pin_threads - привязать поток i к ядру i по модулю числа ядер
+    void Run(bool pin_threads);
+
+    // Потокобезопасен
+    void Stop();
+
+private:
+    std::vector<std::unique_ptr<boost::asio::io_context>> reactors_;
+};
+
+}  // namespace util
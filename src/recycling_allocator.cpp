@@ -0,0 +1,102 @@
+#include "recycling_allocator.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <new>
+#include <utility>
+
+namespace util {
+
+namespace {
+
+constexpr std::size_t CLASS_COUNT = std::countr_zero(ThreadMemoryPool::MAX_BLOCK) - std::countr_zero(ThreadMemoryPool::MIN_BLOCK) + 1;
+
+// Свободный блок хранит указатель на следующий свободный блок того же класса
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Взводится, когда списки потока уничтожены: выделения и освобождения из деструкторов других thread_local
+// после этого идут прямо в кучу
+thread_local bool lists_destroyed = false;
+
+struct FreeLists {
+    FreeLists() = default;
+    FreeLists(const FreeLists&) = delete;
+    FreeLists& operator=(const FreeLists&) = delete;
+
+    ~FreeLists() {
+        lists_destroyed = true;
+        for (std::size_t size_class = 0; size_class < CLASS_COUNT; ++size_class) {
+            auto*& head = heads[size_class];
+            while (head) {
+                ::operator delete(std::exchange(head, head->next));
+            }
+            counts[size_class] = 0;
+        }
+    }
+
+    std::array<FreeBlock*, CLASS_COUNT> heads{};
+    std::array<std::size_t, CLASS_COUNT> counts{};
+};
+
+thread_local FreeLists free_lists;
+
+size_t SizeClass(std::size_t size) noexcept {
+    return std::countr_zero(std::bit_ceil(std::max(size, ThreadMemoryPool::MIN_BLOCK))) - std::countr_zero(ThreadMemoryPool::MIN_BLOCK);
+}
+
+constexpr std::size_t BlockSize(std::size_t size_class) noexcept {
+    return ThreadMemoryPool::MIN_BLOCK << size_class;
+}
+
+constexpr std::size_t MaxFreeBlocks(std::size_t size_class) noexcept {
+    return std::max<std::size_t>(1, ThreadMemoryPool::MAX_FREE_BYTES_PER_CLASS / BlockSize(size_class));
+}
+
+}  // namespace
+
+void* ThreadMemoryPool::Allocate(std::size_t size) {
+    if (size > MAX_BLOCK || lists_destroyed) {
+        return ::operator new(size);
+    }
+    const auto size_class = SizeClass(size);
+    if (auto*& head = free_lists.heads[size_class]) {
+        --free_lists.counts[size_class];
+        return std::exchange(head, head->next);
+    }
+    return ::operator new(BlockSize(size_class));
+}
+
+void ThreadMemoryPool::Deallocate(void* ptr, std::size_t size) noexcept {
+    if (!ptr) {
+        return;
+    }
+    if (size > MAX_BLOCK || lists_destroyed) {
+        ::operator delete(ptr);
+        return;
+    }
+    const auto size_class = SizeClass(size);
+    auto& count = free_lists.counts[size_class];
+    if (count == MaxFreeBlocks(size_class)) {
+        ::operator delete(ptr);
+        return;
+    }
+    ++count;
+    auto& head = free_lists.heads[size_class];
+    head = new (ptr) FreeBlock{head};
+}
+
+std::size_t ThreadMemoryPool::GetRetainedBytes() noexcept {
+    if (lists_destroyed) {
+        return 0;
+    }
+    std::size_t bytes = 0;
+    for (std::size_t size_class = 0; size_class < CLASS_COUNT; ++size_class) {
+        bytes += free_lists.counts[size_class] * BlockSize(size_class);
+    }
+    return bytes;
+}
+
+}  // namespace util
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+
+namespace util {
+
+// Пул блоков памяти потока. Освобождённый блок не возвращается в кучу, а кладётся в список своего класса
+// размера (степени двойки от MIN_BLOCK до MAX_BLOCK) и отдаётся следующему выделению того же класса.
+// После прогрева повторяющиеся выделения похожих размеров к куче не обращаются.
+// Блок можно освободить в другом потоке: он попадёт в пул того потока. Память, которая течёт между потоками
+// в одну сторону (запрос разбирается в потоке сессии, а уничтожается в api_strand), иначе копилась бы
+// в пуле освобождающего потока, поэтому список класса хранит не больше MAX_FREE_BYTES_PER_CLASS байт
+// (но хотя бы один блок), а лишние блоки возвращаются в кучу
+class ThreadMemoryPool {
+public:
+    static constexpr std::size_t MIN_BLOCK = 64;
+    static constexpr std::size_t MAX_BLOCK = std::size_t{1} << 20;
+    static constexpr std::size_t MAX_FREE_BYTES_PER_CLASS = 256 * 1024;
+
+    // Блоки больше MAX_BLOCK выделяются и освобождаются напрямую
+    static void* Allocate(std::size_t size);
+    static void Deallocate(void* ptr, std::size_t size) noexcept;
+
+    // Сколько байт свободных блоков держит пул текущего потока
+    static std::size_t GetRetainedBytes() noexcept;
+};
+
+// Аллокатор поверх ThreadMemoryPool. Состояния не имеет, все экземпляры взаимозаменяемы
+template <typename T>
+class RecyclingAllocator {
+public:
+    using value_type = T;
+
+    RecyclingAllocator() noexcept = default;
+
+    template <typename U>
+    RecyclingAllocator(const RecyclingAllocator<U>&) noexcept {
+    }
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(ThreadMemoryPool::Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept {
+        ThreadMemoryPool::Deallocate(ptr, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const RecyclingAllocator<U>&) const noexcept {
+        return true;
+    }
+};
+
+}  // namespace util
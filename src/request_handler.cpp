@@ -1,7 +1,11 @@
 #include "request_handler.h"
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
+#include <array>
+#include <charconv>
 #include <exception>
+#include <random>
 #include <unordered_map>
 #include <optional>
 
@@ -50,8 +54,8 @@ bool IsSubPath(fs::path path, fs::path base) {
     return true;
 }
 
-std::string UrlDecode(std::string_view str) {
-    std::string decoded;
+PooledString UrlDecode(std::string_view str) {
+    PooledString decoded;
     decoded.reserve(str.size());
 
     for (auto i = str.begin(), nd = str.end(); i != nd; ++i) {
@@ -91,19 +95,22 @@ ParsedURL ParseUrl(std::string_view url) {
         throw httpException(http::status::bad_request, "badRequest"sv, "Multiple '?' in path"sv, {{"Cache-Control"s, "no-cache"s}});
     }
     if (query_pos != std::string_view::npos) {
+        // Пары разделены '&', ключ и значение - '='. Значение продолжается до следующего '=', если он есть
         auto query = url.substr(query_pos + 1);
-        std::vector<std::string_view> pairs;
-        boost::algorithm::split(pairs, query, boost::is_any_of("&"));
-        for (const auto& pair : pairs) {
-            std::vector<std::string_view> kv;
-            boost::algorithm::split(kv, pair, boost::is_any_of("="));
-            if (kv.empty()) continue;
-            auto key = kv[0];
+        while (true) {
+            const auto pair_end = query.find('&');
+            const auto pair = query.substr(0, pair_end);
+            const auto key_end = pair.find('=');
+            const auto key = pair.substr(0, key_end);
             if (key.empty()) {
                 throw httpException(http::status::bad_request, "badRequest"sv, "Empty key in parameters"sv, {{"Cache-Control"s, "no-cache"s}});
             }
-            auto value = kv.size() > 1 ? kv[1] : ""sv;
+            const auto value = key_end == std::string_view::npos ? ""sv : pair.substr(key_end + 1, pair.find('=', key_end + 1) - key_end - 1);
             result.parameters.emplace(key, value);
+            if (pair_end == std::string_view::npos) {
+                break;
+            }
+            query.remove_prefix(pair_end + 1);
         }
     }
     result.path = url.substr(0, query_pos);
@@ -134,8 +141,132 @@ StringResponse MakeStringResponse(http::status status, std::string_view body, un
     return response;
 }
 
-StringResponse MakeJsonResponse(const StringRequest& req, http::status status, std::string_view json, std::vector<std::pair<std::string, std::string>> fields = {}) {
-    return MakeStringResponse(status, json, req.version(), req.keep_alive(), ContentType::APPLICATION_JSON, req.method() == http::verb::head, std::move(fields));
+// Сериализует json-значение прямо в тело ответа, без промежуточной строки.
+// Сериализатор у потока свой: его стек вложенности выделяется один раз, а не на каждый ответ
+template <typename Json>
+void SerializeToBody(const Json& value, StringResponse& response) {
+    thread_local json::serializer sr;
+    sr.reset(&value);
+    auto& body = response.body();
+    while(!sr.done()) {
+        const auto written = body.size();
+        body.resize(std::max(written * 2, written + 512));
+        body.resize(written + sr.read(body.data() + written, body.size() - written).size());
+    }
+}
+
+template <typename Json>
+StringResponse MakeJsonResponse(const StringRequest& req, http::status status, const Json& value, const std::vector<std::pair<std::string, std::string>>& fields = {}) {
+    StringResponse response(status, req.version());
+    response.set(http::field::content_type, ContentType::APPLICATION_JSON);
+    response.keep_alive(req.keep_alive());
+
+    SerializeToBody(value, response);
+    response.content_length(response.body().size());
+    if(req.method() == http::verb::head) {
+        response.body().clear();
+    }
+
+    for(const auto& p : fields) {
+        response.set(p.first, p.second);
+    }
+
+    return response;
+}
+
+// Целочисленный ключ json-объекта. Хранит запись числа в себе, поэтому обходится без временной строки
+class NumberKey {
+public:
+    template <typename Integer>
+    explicit NumberKey(Integer number) {
+        size_ = std::to_chars(buffer_.data(), buffer_.data() + buffer_.size(), number).ptr - buffer_.data();
+    }
+
+    operator json::string_view() const noexcept {
+        return {buffer_.data(), size_};
+    }
+
+private:
+    std::array<char, 24> buffer_;
+    size_t size_;
+};
+
+const std::vector<std::pair<std::string, std::string>> NO_CACHE{{"Cache-Control"s, "no-cache"s}};
+
+// Случайное число, выбираемое при запуске сервера. После перезапуска номера сессий и версии начинаются заново,
+// и эпоха не даёт клиенту получить 304 на ETag из прошлого запуска
+const uint64_t ETAG_EPOCH = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+
+// Сильный ETag версии состояния сессии вида "эпоха-сессия-версия". Собирается в буфере без выделения памяти
+class ETag {
+public:
+    ETag(uint64_t session_uid, uint64_t version) {
+        auto* const end = buffer_.data() + buffer_.size();
+        auto* ptr = buffer_.data();
+        *ptr++ = '"';
+        ptr = std::to_chars(ptr, end, ETAG_EPOCH, 16).ptr;
+        *ptr++ = '-';
+        ptr = std::to_chars(ptr, end, session_uid).ptr;
+        *ptr++ = '-';
+        ptr = std::to_chars(ptr, end, version).ptr;
+        *ptr++ = '"';
+        size_ = ptr - buffer_.data();
+    }
+
+    operator std::string_view() const noexcept {
+        return {buffer_.data(), size_};
+    }
+
+private:
+    // Кавычки, два дефиса, 16 шестнадцатеричных и 2 * 20 десятичных цифр
+    std::array<char, 60> buffer_;
+    size_t size_;
+};
+
+bool ETagMatches(std::string_view if_none_match, std::string_view etag) {
+    while(!if_none_match.empty()) {
+        const auto comma = if_none_match.find(',');
+        auto candidate = if_none_match.substr(0, comma);
+        if_none_match = comma == std::string_view::npos ? ""sv : if_none_match.substr(comma + 1);
+
+        while(!candidate.empty() && candidate.front() == ' ') {
+            candidate.remove_prefix(1);
+        }
+        while(!candidate.empty() && candidate.back() == ' ') {
+            candidate.remove_suffix(1);
+        }
+        if(candidate.starts_with("W/"sv)) {
+            candidate.remove_prefix(2);
+        }
+        if(candidate == "*"sv || candidate == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+StringResponse MakeNotModifiedResponse(const StringRequest& req, std::string_view etag) {
+    StringResponse response(http::status::not_modified, req.version());
+    response.keep_alive(req.keep_alive());
+    response.set(http::field::etag, etag);
+    response.set(http::field::cache_control, "no-cache"sv);
+    response.set(http::field::vary, "Authorization"sv);
+    return response;
+}
+
+// Версия из параметра waitForTick, если он задан
+std::optional<uint64_t> ParseWaitForTick(const ParsedURL& url) {
+    const auto it = url.parameters.find("waitForTick"sv);
+    if(it == url.parameters.end()) {
+        return std::nullopt;
+    }
+    const auto& value = it->second;
+    uint64_t version;
+    const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), version);
+    if(ec != std::errc{} || ptr != value.data() + value.size()) {
+        throw httpException(http::status::bad_request, "invalidArgument"sv, "Invalid waitForTick"sv, {{"Cache-Control"s, "no-cache"s}});
+    }
+    return version;
 }
 
 FileResponse MakeFileResponse(http::status status, fs::path path, unsigned http_version,
@@ -149,7 +280,7 @@ FileResponse MakeFileResponse(http::status status, fs::path path, unsigned http_
     if(!is_head) {
         http::file_body::value_type file;
         if (sys::error_code ec; file.open(path.c_str(), beast::file_mode::read, ec), ec) {
-            throw httpException(http::status::internal_server_error, "internalServerError", ec.what());
+            throw httpException(http::status::internal_server_error, "internalServerError", ec.message());
         }
         response.body() = std::move(file);
         response.prepare_payload();
@@ -164,18 +295,51 @@ FileResponse MakeFileResponse(http::status status, fs::path path, unsigned http_
     return response;
 }
 
-StringResponse RequestHandler::ReportServerError(unsigned version, bool keep_alive) const {
-    const auto json_response = [version, keep_alive](http::status status, std::string_view json, std::vector<std::pair<std::string, std::string>> fields) {
-        return MakeStringResponse(status, json, version, keep_alive, ContentType::APPLICATION_JSON, false, std::move(fields));
-    };
+void RequestHandler::OnTick([[maybe_unused]] std::chrono::milliseconds delta) {
+    // Ответы уходят отдельными заданиями api_strand_: тик мог прийти из обработчика /api/v1/game/tick,
+    // арена которого ещё занята
+    for(auto& waiter : tick_waiters_) {
+        waiter->deadline.cancel();
+        net::post(api_strand_, [self = shared_from_this(), respond = std::move(waiter->respond)] {
+            respond();
+        });
+    }
+    tick_waiters_.clear();
+}
+
+void RequestHandler::WaitForTick(std::function<void()> respond) {
+    auto waiter = std::make_shared<TickWaiter>(api_strand_, std::move(respond));
+    waiter->deadline.expires_after(long_poll_timeout_);
+    waiter->deadline.async_wait([self = shared_from_this(), weak_waiter = std::weak_ptr{waiter}](sys::error_code ec) {
+        // Ожидание отменено или запрос уже забран тиком
+        auto waiter = weak_waiter.lock();
+        if(ec || !waiter) {
+            return;
+        }
+        std::erase(self->tick_waiters_, waiter);
+        // Версия не изменилась, и клиент получит текущее состояние с тем же ETag
+        waiter->respond();
+    });
+    tick_waiters_.push_back(std::move(waiter));
+}
 
+StringResponse MakeErrorResponse(const httpException& e, unsigned version, bool keep_alive) {
+    unsigned char buffer[1024];
+    json::monotonic_resource arena{buffer, sizeof(buffer)};
+    json::object resp_js(&arena);
+    resp_js["code"] = e.GetCode();
+    resp_js["message"] = e.GetMessage();
+    auto response = MakeStringResponse(e.GetStatus(), {}, version, keep_alive, ContentType::APPLICATION_JSON, false, e.GetAdditionalFields());
+    SerializeToBody(resp_js, response);
+    response.content_length(response.body().size());
+    return response;
+}
+
+StringResponse RequestHandler::ReportServerError(unsigned version, bool keep_alive) const {
     try {
         std::rethrow_exception(std::current_exception());
     } catch(const httpException& e) {
-        boost::json::object resp_js{};
-        resp_js["code"] = e.GetCode();
-        resp_js["message"] = e.GetMessage();
-        return json_response(e.GetStatus(), boost::json::serialize(resp_js), e.GetAdditionalFields());
+        return MakeErrorResponse(e, version, keep_alive);
     }
 }
 
@@ -220,32 +384,53 @@ void EnsureCorrectCT(const StringRequest& req, std::string_view ct_sv) {
     }
 }
 
-auto ParseJsonBody(const StringRequest& req) {
-    return json::parse(req.body());
+auto ParseJsonBody(const StringRequest& req, const json::storage_ptr& sp) {
+    return json::parse(req.body(), sp);
 }
 
-auto ParseAuthToken(const StringRequest& req) {
+std::string_view ParseAuthToken(const StringRequest& req) {
     auto auth = GetField(req, "Authorization"sv);
     if(!auth || !auth->starts_with("Bearer "sv) || auth->size() != 39) {
         throw httpException(http::status::unauthorized, "invalidToken"sv, "Authorization header is missing"sv, {{"Cache-Control"s, "no-cache"s}});
     }
-    return model::Token{std::string(auth->substr(7))};
+    return auth->substr(7);
 }
 
-model::Player* ApiHandler::AuthPlayer(const StringRequest& req) const {
-    auto token = ParseAuthToken(req);
-    auto player = app_.FindPlayerByToken(token);
+std::string_view ParseAuthToken(const StringRequest& req, const ParsedURL& url) {
+    if(auto it = url.parameters.find("token"sv); it != url.parameters.end() && it->second.size() == 32) {
+        return it->second;
+    }
+    return ParseAuthToken(req);
+}
+
+const model::PlayerPtr& FindPlayer(app::Application& app, std::string_view token) {
+    auto player = app.FindPlayerByToken(token);
     if(!player) {
         throw httpException(http::status::unauthorized, "unknownToken"sv, "Player token has not been found"sv, {{"Cache-Control"s, "no-cache"s}});
     }
-    return player.value().get().get();
+    return player->get();
+}
+
+std::string_view ParseMoveAction(const json::value& action) {
+    try {
+        const std::string_view move = action.as_object().at("move").as_string();
+        if(move == "L"sv || move == "R"sv || move == "U"sv || move == "D"sv || move == ""sv) {
+            return move;
+        }
+    } catch(const std::exception&) {
+    }
+    throw httpException(http::status::bad_request, "invalidArgument"sv, "Failed to parse action"sv, {{"Cache-Control"s, "no-cache"s}});
+}
+
+model::Player* ApiHandler::AuthPlayer(const StringRequest& req) const {
+    return FindPlayer(app_, ParseAuthToken(req)).get();
 }
 
 bool ApiHandler::isApiRequest(const StringRequest& req) {
     return req.target().starts_with("/api/"sv);
 }
 
-StringResponse ApiHandler::Join(const StringRequest& req) {
+StringResponse ApiHandler::Join(const StringRequest& req, const json::storage_ptr& sp) {
     const bool is_post = req.method() == http::verb::post;
 
     if(!is_post) {
@@ -254,12 +439,12 @@ StringResponse ApiHandler::Join(const StringRequest& req) {
 
     EnsureCorrectCT(req, "application/json"sv);
 
-    json::value post_json;
+    json::value post_json(sp);
     std::string_view user_name;
     std::string_view map_id_sv;
 
     try {
-        post_json = ParseJsonBody(req);
+        post_json = ParseJsonBody(req, sp);
         auto& post_json_obj = post_json.as_object();
         user_name = post_json_obj.at("userName").as_string();
         map_id_sv = post_json_obj.at("mapId").as_string();
@@ -279,14 +464,14 @@ StringResponse ApiHandler::Join(const StringRequest& req) {
 
     auto join_res = app_.JoinGame(map_id, user_name);
 
-    json::object resp_js;
+    json::object resp_js(sp);
     resp_js["authToken"] = *join_res.second;
     resp_js["playerId"] = join_res.first->GetId();
 
-    return MakeJsonResponse(req, http::status::ok, boost::json::serialize(resp_js), {{"Cache-Control"s, "no-cache"s}});
+    return MakeJsonResponse(req, http::status::ok, resp_js, NO_CACHE);
 }
 
-StringResponse ApiHandler::GetPlayers(const StringRequest& req) {
+StringResponse ApiHandler::GetPlayers(const StringRequest& req, const json::storage_ptr& sp) {
     const bool is_get = req.method() == http::verb::get;
     const bool is_head = req.method() == http::verb::head;
 
@@ -296,81 +481,114 @@ StringResponse ApiHandler::GetPlayers(const StringRequest& req) {
 
     AuthPlayer(req);
 
-    json::object resp_js{};
+    json::object resp_js(sp);
 
     for(const auto& [p_id, p] : app_.GetPlayers().GetPlayers()) {
-        resp_js[std::to_string(p_id)] = json::object{{"name"s, p->GetName()}};
+        resp_js[NumberKey{p_id}] = json::object({{"name", p->GetName()}}, sp);
     }
 
-    return MakeJsonResponse(req, http::status::ok, boost::json::serialize(resp_js), {{"Cache-Control"s, "no-cache"s}});
+    return MakeJsonResponse(req, http::status::ok, resp_js, NO_CACHE);
 }
 
-StringResponse ApiHandler::GetGameState(const StringRequest& req) {
-    const bool is_get = req.method() == http::verb::get;
-    const bool is_head = req.method() == http::verb::head;
-
-    if(!is_get && !is_head) {
-        throw httpException(http::status::method_not_allowed, "invalidMethod"sv, "Invalid method"sv, {{"Allow"s, "GET, HEAD"s}, {"Cache-Control"s, "no-cache"s}});
-    }
-
-    auto player = AuthPlayer(req);
-
-    json::object resp_js{};
+json::object SerializeGameState(model::GameSession& session, const json::storage_ptr& sp) {
+    json::object resp_js(sp);
     
-    json::object players_js{};
-    for(const auto& [dog_id, dog] : player->GetSession()->GetDogs()) {
-        json::object dog_js{};
-        dog_js["pos"] = json::array{dog->GetPos().x, dog->GetPos().y};
-        dog_js["speed"] = json::array{dog->GetVelocity().x, dog->GetVelocity().y};
-        dog_js["dir"] = std::string(model::DIR_TO_STRING[static_cast<size_t>(dog->GetDir())]);
-
-        json::array bag_js{};
-        for(const auto& [id, type] : dog->GetBag()) {
-            json::object item_js{};
+    json::object players_js(sp);
+    auto& dogs = session.GetDogs();
+    players_js.reserve(dogs.Size());
+    for(model::DogTable::Slot slot = 0; slot < dogs.Size(); ++slot) {
+        auto dog = dogs[slot];
+        json::object dog_js(sp);
+        dog_js["pos"] = json::array({dog.GetPos().x, dog.GetPos().y}, sp);
+        dog_js["speed"] = json::array({dog.GetVelocity().x, dog.GetVelocity().y}, sp);
+        const auto dir = model::DIR_TO_STRING[static_cast<size_t>(dog.GetDir())];
+        dog_js["dir"] = json::string_view{dir.data(), dir.size()};
+
+        json::array bag_js(sp);
+        for(const auto& [id, type] : dog.GetBag()) {
+            json::object item_js(sp);
             item_js["id"] = id;
             item_js["type"] = type;
             bag_js.emplace_back(std::move(item_js));
         }
         dog_js["bag"] = std::move(bag_js);
 
-        dog_js["score"] = dog->GetScore();
+        dog_js["score"] = dog.GetScore();
 
-        players_js[std::to_string(dog->GetId())] = std::move(dog_js);
+        players_js[NumberKey{dog.GetId()}] = std::move(dog_js);
     }
     resp_js["players"] = std::move(players_js);
 
-    json::object lost_obj_js{};
-    for(const auto& [id, type_pos] : player->GetSession()->GetLoot()) {
-        json::object obj_js{};
+    json::object lost_obj_js(sp);
+    for(const auto& [id, type_pos] : session.GetLoot()) {
+        json::object obj_js(sp);
         obj_js["type"] = type_pos.first;
-        obj_js["pos"] = json::array{type_pos.second.x, type_pos.second.y};
-        lost_obj_js[std::to_string(id)] = std::move(obj_js);
+        obj_js["pos"] = json::array({type_pos.second.x, type_pos.second.y}, sp);
+        lost_obj_js[NumberKey{id}] = std::move(obj_js);
     }
     resp_js["lostObjects"] = std::move(lost_obj_js);
 
-    return MakeJsonResponse(req, http::status::ok, boost::json::serialize(resp_js), {{"Cache-Control"s, "no-cache"s}});
+    return resp_js;
+}
+
+bool ApiHandler::ShouldWaitForTick(const StringRequest& req, const ParsedURL& url) const {
+    if(url.path != "api/v1/game/state"sv) {
+        return false;
+    }
+    try {
+        const auto wait_for = ParseWaitForTick(url);
+        return wait_for && AuthPlayer(req)->GetSession()->GetVersion() == *wait_for;
+    } catch(const httpException&) {
+        // На неверный запрос GetGameState ответит ошибкой сразу
+        return false;
+    }
+}
+
+StringResponse ApiHandler::GetGameState(const StringRequest& req, const ParsedURL& url, const json::storage_ptr& sp) {
+    const bool is_get = req.method() == http::verb::get;
+    const bool is_head = req.method() == http::verb::head;
+
+    if(!is_get && !is_head) {
+        throw httpException(http::status::method_not_allowed, "invalidMethod"sv, "Invalid method"sv, {{"Allow"s, "GET, HEAD"s}, {"Cache-Control"s, "no-cache"s}});
+    }
+
+    auto player = AuthPlayer(req);
+    ParseWaitForTick(url);
+
+    // Клиент, у которого уже есть эта версия, получает 304 без сборки состояния
+    auto& session = *player->GetSession();
+    const ETag etag{session.GetUid(), session.GetVersion()};
+    if(auto it = req.find(http::field::if_none_match); it != req.end() && ETagMatches(it->value(), etag)) {
+        return MakeNotModifiedResponse(req, etag);
+    }
+
+    // Состояние зависит от токена игрока: кэш не должен отдавать его другому игроку
+    auto response = MakeJsonResponse(req, http::status::ok, SerializeGameState(session, sp), NO_CACHE);
+    response.set(http::field::etag, etag);
+    response.set(http::field::vary, "Authorization"sv);
+    return response;
 }
 
-boost::json::array SerializeRoads(const std::vector<std::unique_ptr<model::Road>>& roads) {
-    boost::json::array roads_array{};
+boost::json::array SerializeRoads(const model::Map::Roads& roads, const json::storage_ptr& sp) {
+    boost::json::array roads_array(sp);
     for(const auto& road : roads) {
-        boost::json::object road_obj{};
-        road_obj["x0"] = road->GetStart().x;
-        road_obj["y0"] = road->GetStart().y;
-        if(road->IsHorizontal()) {
-            road_obj["x1"] = road->GetEnd().x;
+        boost::json::object road_obj(sp);
+        road_obj["x0"] = road.GetStart().x;
+        road_obj["y0"] = road.GetStart().y;
+        if(road.IsHorizontal()) {
+            road_obj["x1"] = road.GetEnd().x;
         } else {
-            road_obj["y1"] = road->GetEnd().y;
+            road_obj["y1"] = road.GetEnd().y;
         }
         roads_array.emplace_back(std::move(road_obj));
     }
     return roads_array;
 }
 
-boost::json::array SerializeBuildings(const std::vector<model::Building>& buildings) {
-    boost::json::array buildings_array{};
+boost::json::array SerializeBuildings(const std::vector<model::Building>& buildings, const json::storage_ptr& sp) {
+    boost::json::array buildings_array(sp);
     for(const auto& building : buildings) {
-        boost::json::object building_obj{};
+        boost::json::object building_obj(sp);
         building_obj["x"] = building.GetBounds().position.x;
         building_obj["y"] = building.GetBounds().position.y;
         building_obj["w"] = building.GetBounds().size.width;
@@ -380,10 +598,10 @@ boost::json::array SerializeBuildings(const std::vector<model::Building>& buildi
     return buildings_array;
 }
 
-boost::json::array SerializeOffices(const std::vector<model::Office>& offices) {
-    boost::json::array offices_array{};
+boost::json::array SerializeOffices(const std::vector<model::Office>& offices, const json::storage_ptr& sp) {
+    boost::json::array offices_array(sp);
     for(const auto& office : offices) {
-        boost::json::object office_obj{};
+        boost::json::object office_obj(sp);
         office_obj["id"] = *office.GetId();
         office_obj["x"] = office.GetPosition().x;
         office_obj["y"] = office.GetPosition().y;
@@ -394,18 +612,18 @@ boost::json::array SerializeOffices(const std::vector<model::Office>& offices) {
     return offices_array;
 }
 
-boost::json::object SerializeMap(const model::Map& map) {
-    boost::json::object out_obj{};
+boost::json::object SerializeMap(const model::Map& map, const json::storage_ptr& sp) {
+    boost::json::object out_obj(sp);
     out_obj["id"] = *map.GetId();
     out_obj["name"] = map.GetName();
-    out_obj["roads"] = SerializeRoads(map.GetRoads());
-    out_obj["buildings"] = SerializeBuildings(map.GetBuildings());
-    out_obj["offices"] = SerializeOffices(map.GetOffices());
+    out_obj["roads"] = SerializeRoads(map.GetRoads(), sp);
+    out_obj["buildings"] = SerializeBuildings(map.GetBuildings(), sp);
+    out_obj["offices"] = SerializeOffices(map.GetOffices(), sp);
     out_obj["lootTypes"] = map.GetExtraData().GetLootTypes();
     return out_obj;
 }
 
-StringResponse ApiHandler::GetMap(const StringRequest& req) {
+StringResponse ApiHandler::GetMap(const StringRequest& req, const json::storage_ptr& sp) {
     const bool is_get = req.method() == http::verb::get;
     const bool is_head = req.method() == http::verb::head;
 
@@ -420,11 +638,11 @@ StringResponse ApiHandler::GetMap(const StringRequest& req) {
         throw httpException(http::status::not_found, "mapNotFound"sv, "Map not found"sv, {{"Cache-Control"s, "no-cache"s}});
     }
 
-    auto serialized_map = SerializeMap(*map);
-    return MakeJsonResponse(req, http::status::ok, boost::json::serialize(serialized_map), {{"Cache-Control"s, "no-cache"s}});
+    auto serialized_map = SerializeMap(*map, sp);
+    return MakeJsonResponse(req, http::status::ok, serialized_map, NO_CACHE);
 }
 
-StringResponse ApiHandler::GetMaps(const StringRequest& req) {
+StringResponse ApiHandler::GetMaps(const StringRequest& req, const json::storage_ptr& sp) {
     const bool is_get = req.method() == http::verb::get;
     const bool is_head = req.method() == http::verb::head;
 
@@ -432,18 +650,18 @@ StringResponse ApiHandler::GetMaps(const StringRequest& req) {
         throw httpException(http::status::method_not_allowed, "methodNotAllowed"sv, "Method not allowed"sv, {{"Allow"s, "GET, HEAD"s}, {"Cache-Control"s, "no-cache"s}});
     }
 
-    boost::json::array out_arr{};
+    boost::json::array out_arr(sp);
     for(const auto& map : app_.ListMaps()) {
-        boost::json::object obj{};
+        boost::json::object obj(sp);
         obj["id"] = *map.GetId();
         obj["name"] = map.GetName();
         out_arr.emplace_back(std::move(obj));
     }
 
-    return MakeJsonResponse(req, http::status::ok, boost::json::serialize(out_arr), {{"Cache-Control"s, "no-cache"s}});
+    return MakeJsonResponse(req, http::status::ok, out_arr, NO_CACHE);
 }
 
-StringResponse ApiHandler::SetPlayerAction(const StringRequest& req) {
+StringResponse ApiHandler::SetPlayerAction(const StringRequest& req, const json::storage_ptr& sp) {
     const bool is_post = req.method() == http::verb::post;
 
     if(!is_post) {
@@ -454,26 +672,19 @@ StringResponse ApiHandler::SetPlayerAction(const StringRequest& req) {
 
     EnsureCorrectCT(req, "application/json"sv);
 
-    json::value post_json;
-    std::string_view move;
-
+    json::value post_json(sp);
     try {
-        post_json = ParseJsonBody(req);
-        auto& post_json_obj = post_json.as_object();
-        move = post_json_obj.at("move").as_string();
-        if(move != "L"sv && move != "R"sv && move != "U"sv && move != "D"sv && move != ""sv) {
-            throw std::exception();
-        }
+        post_json = ParseJsonBody(req, sp);
     } catch(std::exception&) {
         throw httpException(http::status::bad_request, "invalidArgument"sv, "Failed to parse action"sv, {{"Cache-Control"s, "no-cache"s}});
     }
 
-    app_.SetPlayerAction(player, move);
+    app_.SetPlayerAction(player, ParseMoveAction(post_json));
 
-    return MakeJsonResponse(req, http::status::ok, boost::json::serialize(json::object{}), {{"Cache-Control"s, "no-cache"s}});
+    return MakeJsonResponse(req, http::status::ok, json::object(sp), NO_CACHE);
 }
 
-StringResponse ApiHandler::Tick(const StringRequest& req) {
+StringResponse ApiHandler::Tick(const StringRequest& req, const json::storage_ptr& sp) {
     const bool is_post = req.method() == http::verb::post;
 
     if(!is_post) {
@@ -482,11 +693,11 @@ StringResponse ApiHandler::Tick(const StringRequest& req) {
 
     EnsureCorrectCT(req, "application/json"sv);
 
-    json::value post_json;
+    json::value post_json(sp);
     int dt;
 
     try {
-        post_json = ParseJsonBody(req);
+        post_json = ParseJsonBody(req, sp);
         auto& post_json_obj = post_json.as_object();
         dt = post_json_obj.at("timeDelta").as_int64();
     } catch(std::exception&) {
@@ -495,10 +706,10 @@ StringResponse ApiHandler::Tick(const StringRequest& req) {
 
     app_.Tick(std::chrono::milliseconds(dt));
 
-    return MakeJsonResponse(req, http::status::ok, boost::json::serialize(json::object{}), {{"Cache-Control"s, "no-cache"s}});
+    return MakeJsonResponse(req, http::status::ok, json::object(sp), NO_CACHE);
 }
 
-StringResponse ApiHandler::GetRecords(const StringRequest& req, const ParsedURL& url) {
+StringResponse ApiHandler::GetRecords(const StringRequest& req, const ParsedURL& url, const json::storage_ptr& sp) {
     const bool is_get = req.method() == http::verb::get;
     const bool is_head = req.method() == http::verb::head;
 
@@ -509,15 +720,15 @@ StringResponse ApiHandler::GetRecords(const StringRequest& req, const ParsedURL&
     int offset = 0;
     int limit = 100;
 
-    if(url.parameters.contains("start")) {
-        offset = std::stoi(url.parameters.at("start"));
+    if(auto it = url.parameters.find("start"sv); it != url.parameters.end()) {
+        offset = std::stoi(std::string(it->second));
         if(offset < 0) {
             throw httpException(http::status::bad_request, "badRequest"sv, "\"start\" out of range"sv, {{"Cache-Control"s, "no-cache"s}});
         }
     }
 
-    if(url.parameters.contains("maxItems")) {
-        limit = std::stoi(url.parameters.at("maxItems"));
+    if(auto it = url.parameters.find("maxItems"sv); it != url.parameters.end()) {
+        limit = std::stoi(std::string(it->second));
         if(limit <= 0 || limit > 100) {
             throw httpException(http::status::bad_request, "badRequest"sv, "\"maxItems\" out of range"sv, {{"Cache-Control"s, "no-cache"s}});
         }
@@ -527,35 +738,40 @@ StringResponse ApiHandler::GetRecords(const StringRequest& req, const ParsedURL&
     auto retired_dogs = uow->GetRetiredDogs().FetchRange(offset, limit);
     uow->Commit();
 
-    boost::json::array out_arr{};
+    boost::json::array out_arr(sp);
     for(const auto& retired_dog : retired_dogs) {
-        boost::json::object obj{};
+        boost::json::object obj(sp);
         obj["name"] = retired_dog.GetName();
         obj["score"] = retired_dog.GetScore();
         obj["playTime"] = ((double)retired_dog.GetPlayTime())/1000.0;
         out_arr.emplace_back(std::move(obj));
     }
 
-    return MakeJsonResponse(req, http::status::ok, boost::json::serialize(out_arr), {{"Cache-Control"s, "no-cache"s}});
+    return MakeJsonResponse(req, http::status::ok, out_arr, NO_CACHE);
 }
 
 StringResponse ApiHandler::HandleApiRequest(const StringRequest& req, const ParsedURL& url) {
+    // Арена запроса: разобранное тело и json ответа живут в ней и освобождаются разом,
+    // когда ответ сериализован в своё тело
+    json::monotonic_resource arena{arena_buffer_.get(), ARENA_BUFFER_SIZE};
+    const json::storage_ptr sp{&arena};
+
     if(url.path == "api/v1/maps"sv) {
-        return GetMaps(req);
+        return GetMaps(req, sp);
     } else if(url.path.starts_with("api/v1/maps/"sv)) {
-        return GetMap(req);
+        return GetMap(req, sp);
     } else if(url.path == "api/v1/game/join"sv) {
-        return Join(req);
+        return Join(req, sp);
     } else if(url.path == "api/v1/game/records"sv) {
-        return GetRecords(req, url);
+        return GetRecords(req, url, sp);
     } else if(url.path == "api/v1/game/players"sv) {
-        return GetPlayers(req);
+        return GetPlayers(req, sp);
     } else if(url.path == "api/v1/game/state"sv) {
-        return GetGameState(req);
+        return GetGameState(req, url, sp);
     } else if(url.path == "api/v1/game/player/action"sv) {
-        return SetPlayerAction(req);
+        return SetPlayerAction(req, sp);
     } else if(url.path == "api/v1/game/tick"sv && serve_tick_endpoint_) {
-        return Tick(req);
+        return Tick(req, sp);
     }
     throw httpException(http::status::bad_request, "badRequest"sv, "Invalid endpoint"sv);
 }
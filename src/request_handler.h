@@ -3,11 +3,18 @@
 #include "log.h"
 #include "app.h"
 
+#include <boost/asio/steady_timer.hpp>
 #include <boost/json.hpp>
 
 #include <filesystem>
 #include <variant>
 #include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace http_handler {
 namespace beast = boost::beast;
@@ -17,10 +24,10 @@ namespace net = boost::asio;
 namespace fs = std::filesystem;
 
 
-using StringRequest = http::request<http::string_body>;
+using StringRequest = http_server::StringRequest;
 
-using StringResponse = http::response<http::string_body>;
-using FileResponse = http::response<http::file_body>;
+using StringResponse = http_server::StringResponse;
+using FileResponse = http_server::FileResponse;
 
 class httpException : public std::exception {
 public:
@@ -54,46 +61,76 @@ private:
     std::vector<std::pair<std::string, std::string>> additional_fields_;
 };
 
-std::string UrlDecode(std::string_view str);
+// Состояние сессии в формате ответа /api/v1/game/state. Изменяемая ссылка нужна только для доступа к таблице собак
+json::object SerializeGameState(model::GameSession& session, const json::storage_ptr& sp);
+
+// Строки разобранного адреса живут в пуле памяти потока, как и сам запрос
+using PooledString = std::basic_string<char, std::char_traits<char>, util::RecyclingAllocator<char>>;
+
+PooledString UrlDecode(std::string_view str);
 struct ParsedURL {
-    std::string path;
-    std::unordered_map<std::string, std::string> parameters;
+    // Параметры ищутся по string_view, без строки для ключа
+    struct KeyHasher {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const noexcept {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+    using Parameters = std::unordered_map<PooledString, PooledString, KeyHasher, std::equal_to<>,
+                                          util::RecyclingAllocator<std::pair<const PooledString, PooledString>>>;
+
+    PooledString path;
+    Parameters parameters;
 };
 ParsedURL ParseUrl(std::string_view url);
 
+// Разбор запросов, общий для обработчиков API и канала WebSocket. Ошибки - httpException с ответом для клиента
+
+// Токен из заголовка Authorization. Указывает в заголовок запроса
+std::string_view ParseAuthToken(const StringRequest& req);
+// Токен из параметра token, а без него из заголовка: браузер не может задать заголовки WebSocket
+std::string_view ParseAuthToken(const StringRequest& req, const ParsedURL& url);
+const model::PlayerPtr& FindPlayer(app::Application& app, std::string_view token);
+// Направление из действия вида {"move": "L"}
+std::string_view ParseMoveAction(const json::value& action);
+StringResponse MakeErrorResponse(const httpException& e, unsigned version, bool keep_alive);
+
+// Ищет etag в списке If-None-Match. Для этого заголовка ETag сравниваются слабо, поэтому префикс W/ не важен
+bool ETagMatches(std::string_view if_none_match, std::string_view etag);
+
+// Пишет запросы и ответы в журнал access_log. Он должен пережить все сессии сервера
 template<class SomeRequestHandler>
 class LoggingRequestHandler {
     template<class Req, typename Endpoint>
-    static void LogRequest(const Req& req, const Endpoint& ep) {
-        using namespace std::literals;
-        logging::LOG_INFO({{"ip", ep.address().to_string()}, {"URI", req.target()}, {"method", http::to_string(req.method())}}, "request received");
+    void LogRequest(const Req& req, const Endpoint& ep) {
+        access_log_.LogRequest(ep.address(), req.target(), http::to_string(req.method()));
     }
     template<class Resp, typename Dur>
-    static void LogResponse(const Resp& resp, Dur dur) {
+    static void LogResponse(logging::AccessLog& access_log, const Resp& resp, Dur dur) {
         const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(dur).count();
-        json::object json_log{{"response_time", millis}, {"code", resp.result_int()}};
-        if(resp.find(http::field::content_type) != resp.end()) {
-            json_log["content_type"] = std::string(resp.at(http::field::content_type));
-        } else {
-            json_log["content_type"] = nullptr;
+        std::optional<std::string_view> content_type;
+        if(auto it = resp.find(http::field::content_type); it != resp.end()) {
+            content_type = it->value();
         }
-        logging::LOG_INFO(std::move(json_log), "response sent");
+        access_log.LogResponse(millis, resp.result_int(), content_type);
     }
 public:
-    explicit LoggingRequestHandler(SomeRequestHandler&& handler) : decorated_{std::forward<SomeRequestHandler>(handler)} {}
+    LoggingRequestHandler(SomeRequestHandler&& handler, logging::AccessLog& access_log)
+        : decorated_{std::forward<SomeRequestHandler>(handler)}, access_log_{access_log} {}
 
     template <typename Request, typename Endpoint, typename Send>
     void operator()(Request&& req, const Endpoint& ep, Send&& send) {
         LogRequest(req, ep);
         const auto start_tp = std::chrono::system_clock::now(); 
-        decorated_(std::forward<Request>(req), [start_tp, send = std::forward<Send>(send)](auto&& resp){
-            LogResponse(resp, std::chrono::system_clock::now() - start_tp);
+        decorated_(std::forward<Request>(req), [start_tp, &access_log = access_log_, send = std::forward<Send>(send)](auto&& resp){
+            LogResponse(access_log, resp, std::chrono::system_clock::now() - start_tp);
             send(std::forward<decltype(resp)>(resp));
         });
     }
 
 private:
      SomeRequestHandler decorated_;
+     logging::AccessLog& access_log_;
 };
 
 class ApiHandler {
@@ -107,21 +144,31 @@ public:
 
     static bool isApiRequest(const StringRequest& req);
     StringResponse HandleApiRequest(const StringRequest& req, const ParsedURL& url);
+    // Долгий опрос: запрос состояния с waitForTick=N, где N - текущая версия состояния сессии,
+    // должен дождаться окончания следующего тика
+    bool ShouldWaitForTick(const StringRequest& req, const ParsedURL& url) const;
 
 private:
+    // Размер начального буфера арены запроса. Его хватает на состояние сессии с парой десятков собак,
+    // большие ответы арена дозапрашивает у кучи крупными блоками
+    static constexpr size_t ARENA_BUFFER_SIZE = 64 * 1024;
+
     model::Player* AuthPlayer(const StringRequest& req) const;
 
-    StringResponse Join(const StringRequest& req);
-    StringResponse GetPlayers(const StringRequest& req);
-    StringResponse SetPlayerAction(const StringRequest& req);
-    StringResponse GetGameState(const StringRequest& req);
-    StringResponse GetMap(const StringRequest& req);
-    StringResponse GetMaps(const StringRequest& req);
-    StringResponse Tick(const StringRequest& req);
-    StringResponse GetRecords(const StringRequest& req, const ParsedURL& url);
+    // Все json-значения обработчиков размещаются в арене запроса sp
+    StringResponse Join(const StringRequest& req, const json::storage_ptr& sp);
+    StringResponse GetPlayers(const StringRequest& req, const json::storage_ptr& sp);
+    StringResponse SetPlayerAction(const StringRequest& req, const json::storage_ptr& sp);
+    StringResponse GetGameState(const StringRequest& req, const ParsedURL& url, const json::storage_ptr& sp);
+    StringResponse GetMap(const StringRequest& req, const json::storage_ptr& sp);
+    StringResponse GetMaps(const StringRequest& req, const json::storage_ptr& sp);
+    StringResponse Tick(const StringRequest& req, const json::storage_ptr& sp);
+    StringResponse GetRecords(const StringRequest& req, const ParsedURL& url, const json::storage_ptr& sp);
 
     app::Application& app_;
     bool serve_tick_endpoint_;
+    // Обработчики API выполняются в api_strand_ строго по одному, поэтому буфер арены общий
+    std::unique_ptr<unsigned char[]> arena_buffer_ = std::make_unique<unsigned char[]>(ARENA_BUFFER_SIZE);
 };
 
 //что бы уж точно ничего лишнего не вылезло наружу, что мы случайно упустили
@@ -137,19 +184,26 @@ auto RequestHandlerWrapper(ClassType* obj, Func func, Args&&... args) {
     }
 }
 
-class RequestHandler : public std::enable_shared_from_this<RequestHandler> {
+class RequestHandler : public app::ApplicationListener, public std::enable_shared_from_this<RequestHandler> {
 public:
     using Strand = net::strand<net::io_context::executor_type>;
 
-    explicit RequestHandler(app::Application& app, fs::path static_path, Strand api_strand, bool serve_tick_endpoint)
-        : static_path_{static_path}, api_handler_{app, serve_tick_endpoint}, api_strand_{api_strand} {
+    // Если тик не наступил за это время, отложенный запрос получает текущее состояние.
+    // Должно быть меньше таймаута запроса в HTTP-сессии (30 с), иначе сессия закроется без ответа
+    static constexpr std::chrono::milliseconds DEFAULT_LONG_POLL_TIMEOUT{10'000};
+
+    explicit RequestHandler(app::Application& app, fs::path static_path, Strand api_strand, bool serve_tick_endpoint,
+                            std::chrono::milliseconds long_poll_timeout = DEFAULT_LONG_POLL_TIMEOUT)
+        : static_path_{static_path}, api_handler_{app, serve_tick_endpoint}, api_strand_{api_strand}, long_poll_timeout_{long_poll_timeout} {
     }
 
     RequestHandler(const RequestHandler&) = delete;
     RequestHandler& operator=(const RequestHandler&) = delete;
 
+    // Запрос принадлежит HTTP-сессии и живёт, пока она не отправит ответ, а сессию держит send.
+    // Поэтому запрос не копируется: задания обработчика ссылаются на него до вызова send
     template <typename Body, typename Allocator, typename Send>
-    void operator()(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
+    void operator()(const http::request<Body, http::basic_fields<Allocator>>& req, Send&& send) {
         using namespace std::literals;
 
         auto version = req.version();
@@ -160,14 +214,17 @@ public:
 
             if(api_handler_.isApiRequest(req)) {
                 auto handle = [self = shared_from_this(), send,
-                               req = std::forward<decltype(req)>(req), version, keep_alive, parsed_url] {
-                    try {
-                        return send(RequestHandlerWrapper(&self->api_handler_, &ApiHandler::HandleApiRequest, req, parsed_url));
-                    } catch (httpException&) {
-                        send(self->ReportServerError(version, keep_alive));
+                               request = &req, version, keep_alive, parsed_url = std::move(parsed_url)]() mutable {
+                    if(self->api_handler_.ShouldWaitForTick(*request, parsed_url)) {
+                        // Отложенный запрос не держит обработчик: его держат задания, которые запускают ответ
+                        return self->WaitForTick([handler = self.get(), send = std::move(send), request, version, keep_alive, parsed_url = std::move(parsed_url)] {
+                            handler->HandleApiRequest(*request, parsed_url, send, version, keep_alive);
+                        });
                     }
+                    self->HandleApiRequest(*request, parsed_url, send, version, keep_alive);
                 };
-                return net::dispatch(api_strand_, handle);
+                // Задание для strand игры берётся из пула потока
+                return net::dispatch(api_strand_, http_server::PooledHandler{std::move(handle)});
             }
             // Возвращаем результат обработки запроса к файлу
             return std::visit(
@@ -180,15 +237,42 @@ public:
         }
     }
 
+    // Отвечает на запросы, ждавшие этого тика
+    void OnTick(std::chrono::milliseconds delta) override;
+
 private:
     using FileRequestResult = std::variant<StringResponse, FileResponse>;
 
+    struct TickWaiter {
+        TickWaiter(Strand strand, std::function<void()> respond)
+            : deadline{strand}, respond{std::move(respond)} {
+        }
+
+        net::steady_timer deadline;
+        std::function<void()> respond;
+    };
+
+    // Откладывает ответ до конца тика или до истечения long_poll_timeout_. Вызывается в api_strand_
+    void WaitForTick(std::function<void()> respond);
+
+    template <typename Request, typename Send>
+    void HandleApiRequest(const Request& req, const ParsedURL& url, const Send& send, unsigned version, bool keep_alive) {
+        try {
+            send(RequestHandlerWrapper(&api_handler_, &ApiHandler::HandleApiRequest, req, url));
+        } catch (httpException&) {
+            send(ReportServerError(version, keep_alive));
+        }
+    }
+
     FileRequestResult HandleFileRequest(const StringRequest& req, const ParsedURL& url) const;
     StringResponse ReportServerError(unsigned version, bool keep_alive) const;
 
     fs::path static_path_;
     ApiHandler api_handler_;
     Strand api_strand_;
+    std::chrono::milliseconds long_poll_timeout_;
+    // Запросы долгого опроса, отложенные до конца тика. Доступ только из api_strand_
+    std::vector<std::shared_ptr<TickWaiter>> tick_waiters_;
 };
 
 }  // namespace http_handler
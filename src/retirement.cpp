@@ -1,20 +1,29 @@
 #include "retirement.h"
 
+#include <utility>
+
 namespace retirement {
 
 void RetirementListener::OnTick([[maybe_unused]] std::chrono::milliseconds delta) {
-    for(auto& [map_id, session] : app_.GetGame().GetSessions()) {
-        for(auto dog_it = session->GetDogs().begin(); dog_it != session->GetDogs().end();) {
-            auto& [dog_id, dog] = *dog_it;
-            if(dog->GetIdleFor() >= app_.GetGame().GetMaxIdleTime()) {
+    for(auto& [map_id, sessions] : app_.GetGame().GetSessions()) {
+        for(auto& session : sessions) {
+            auto& dogs = session->GetDogs();
+            //смотрим только собак, у которых истекло время простоя; неудачные попытки повторим в следующий тик
+            auto expired = std::exchange(session->GetExpiredDogs(), {});
+            for(const auto dog_id : expired) {
+                auto slot = dogs.FindSlot(dog_id);
+                if(!slot || dogs[*slot].GetIdleFor() < app_.GetGame().GetMaxIdleTime()) {
+                    continue;
+                }
+                auto dog = dogs[*slot];
                 try {
                     //without valid transaction everything else is irrelevant
                     auto uow = app_.GetUoW();
 
                     model::RetiredDog retired_dog{model::RetiredDog::Id::New()
-                        , std::string(dog->GetName())
-                        , static_cast<int>(dog->GetScore())
-                        , static_cast<int>(dog->GetAge().count())
+                        , std::string(dog.GetName())
+                        , static_cast<int>(dog.GetScore())
+                        , static_cast<int>(dog.GetAge().count())
                     };
                     uow->GetRetiredDogs().Save(retired_dog);
 
@@ -25,13 +34,11 @@ void RetirementListener::OnTick([[maybe_unused]] std::chrono::milliseconds delta
                     //cleanup state
                     app_.GetTokens().RemoveToken(dog_id);
                     app_.GetPlayers().RemovePlayer(dog_id);
-                    dog_it = session->GetDogs().erase(dog_it);
+                    session->RemoveDog(dog_id);
                 } catch(const std::exception& e) {
                     logging::LOG_INFO({{"what", e.what()}}, "Error: Could not retire dog");
-                    continue;
+                    session->GetExpiredDogs().push_back(dog_id);
                 }
-            } else {
-                ++dog_it;
             }
         }
     }
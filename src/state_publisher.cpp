@@ -0,0 +1,92 @@
+#include "state_publisher.h"
+#include "request_handler.h"
+
+#include <boost/asio/dispatch.hpp>
+#include <boost/json.hpp>
+
+#include <algorithm>
+
+namespace http_handler {
+
+namespace json = boost::json;
+namespace net = boost::asio;
+using namespace std::literals;
+
+StatePublisher::StatePublisher(app::Application& app, Strand api_strand)
+    : app_{app}
+    , api_strand_{api_strand} {
+}
+
+void StatePublisher::Subscribe(http_server::StringRequest&& request, http_server::Socket&& socket) {
+    auto connection = std::make_shared<http_server::WebSocketSession>(std::move(socket));
+    net::dispatch(api_strand_, [self = shared_from_this(), request = std::move(request), connection]() mutable {
+        self->DoSubscribe(std::move(request), connection);
+    });
+}
+
+void StatePublisher::DoSubscribe(http_server::StringRequest&& request, const std::shared_ptr<http_server::WebSocketSession>& connection) {
+    model::PlayerPtr player;
+    try {
+        const auto url = ParseUrl(UrlDecode(request.target()));
+        if(url.path != "api/v1/game/ws"sv) {
+            throw httpException(http::status::not_found, "badRequest"sv, "Invalid endpoint"sv, {{"Cache-Control"s, "no-cache"s}});
+        }
+        player = FindPlayer(app_, ParseAuthToken(request, url));
+    } catch(const httpException& e) {
+        return connection->Reject(MakeErrorResponse(e, request.version(), request.keep_alive()));
+    }
+
+    std::weak_ptr<model::Player> weak_player = player;
+    // Обработчик живёт в соединении, которое может пережить io_context игры, поэтому ссылка на себя слабая
+    connection->Accept(std::move(request), [weak_self = weak_from_this(), weak_player](std::string message) {
+        if(auto self = weak_self.lock()) {
+            net::dispatch(self->api_strand_, [self, weak_player, message = std::move(message)] {
+                self->OnMessage(weak_player, message);
+            });
+        }
+    });
+    subscribers_.push_back({connection, weak_player});
+
+    // Первое состояние клиент получает сразу, не дожидаясь тика
+    connection->Push(MakeFrame(*player->GetSession()));
+}
+
+void StatePublisher::OnMessage(const std::weak_ptr<model::Player>& weak_player, std::string_view message) {
+    auto player = weak_player.lock();
+    if(!player) {
+        return;
+    }
+    try {
+        app_.SetPlayerAction(player.get(), ParseMoveAction(json::parse(message)));
+    } catch(const std::exception&) {
+        // Неразборчивое сообщение игнорируется, как и у HTTP-клиента, приславшего неверное действие
+    }
+}
+
+void StatePublisher::OnTick([[maybe_unused]] std::chrono::milliseconds delta) {
+    frames_.clear();
+    std::erase_if(subscribers_, [this](const Subscriber& subscriber) {
+        auto connection = subscriber.connection.lock();
+        if(!connection) {
+            return true;
+        }
+        auto player = subscriber.player.lock();
+        if(!player) {
+            connection->Close();
+            return true;
+        }
+        auto& frame = frames_[player->GetSession().get()];
+        if(!frame) {
+            frame = MakeFrame(*player->GetSession());
+        }
+        connection->Push(frame);
+        return false;
+    });
+}
+
+http_server::Frame StatePublisher::MakeFrame(model::GameSession& session) {
+    json::monotonic_resource arena{arena_buffer_.get(), ARENA_BUFFER_SIZE};
+    return std::make_shared<const std::string>(json::serialize(SerializeGameState(session, &arena)));
+}
+
+}  // namespace http_handler
@@ -0,0 +1,49 @@
+#pragma once
+#include "app.h"
+#include "websocket_session.h"
+
+#include <boost/asio/strand.hpp>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace http_handler {
+
+// Канал /api/v1/game/ws. Игрок подключается один раз с токеном (параметр token или заголовок Authorization),
+// присылает действия сообщениями {"move": "L"} и после каждого тика получает состояние своей сессии.
+// Состояние сериализуется один раз на сессию, и этот кадр получают все её подписчики.
+// Работает в api_strand вместе с остальными обработчиками API
+class StatePublisher : public app::ApplicationListener, public std::enable_shared_from_this<StatePublisher> {
+public:
+    using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+
+    StatePublisher(app::Application& app, Strand api_strand);
+
+    // Принимает сокет HTTP-сессии, запросившей переход на WebSocket. Можно вызывать из любого потока
+    void Subscribe(http_server::StringRequest&& request, http_server::Socket&& socket);
+
+    void OnTick(std::chrono::milliseconds delta) override;
+
+private:
+    static constexpr size_t ARENA_BUFFER_SIZE = 64 * 1024;
+
+    struct Subscriber {
+        std::weak_ptr<http_server::WebSocketSession> connection;
+        // Игрок пропадает, когда собака уходит на пенсию, и подписка тогда закрывается
+        std::weak_ptr<model::Player> player;
+    };
+
+    void DoSubscribe(http_server::StringRequest&& request, const std::shared_ptr<http_server::WebSocketSession>& connection);
+    void OnMessage(const std::weak_ptr<model::Player>& player, std::string_view message);
+    http_server::Frame MakeFrame(model::GameSession& session);
+
+    app::Application& app_;
+    Strand api_strand_;
+    std::vector<Subscriber> subscribers_;
+    // Кадры сессий текущего тика, переиспользуется между тиками
+    std::unordered_map<const model::GameSession*, http_server::Frame> frames_;
+    std::unique_ptr<unsigned char[]> arena_buffer_ = std::make_unique<unsigned char[]>(ARENA_BUFFER_SIZE);
+};
+
+}  // namespace http_handler
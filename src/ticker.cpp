@@ -12,6 +12,10 @@ Ticker::Ticker(Strand strand, std::chrono::milliseconds period, Handler handler)
     , handler_{std::move(handler)} {
 }
 
+void Ticker::SetFixedTimestep(unsigned max_steps) {
+    fixed_timestep_.emplace(period_, max_steps);
+}
+
 void Ticker::Start() {
     boost::asio::dispatch(strand_, [self = shared_from_this()] {
         self->last_tick_ = Clock::now();
@@ -32,18 +36,30 @@ void Ticker::OnTick(boost::system::error_code ec) {
     assert(strand_.running_in_this_thread());
 
     if (!ec) {
-        auto this_tick = Clock::now();
-        auto delta = duration_cast<milliseconds>(this_tick - last_tick_);
-        last_tick_ = this_tick;
-        try {
-            handler_(delta);
-        } catch (std::exception&) {
-            // Теоретически этого не должно произойти
-            // Пользователь класса Ticker должен предоставить handler, который корректно обработает все exception'ы
-            // Но если мы всё же тут оказались, то проигнорируем это исключение
+        // Остаток меньше миллисекунды не теряется, а переходит в следующий тик
+        const auto delta = duration_cast<milliseconds>(Clock::now() - last_tick_);
+        last_tick_ += delta;
+        if (fixed_timestep_) {
+            // Шаг, завершившийся исключением, не отменяет оставшиеся шаги
+            for (auto steps = fixed_timestep_->Advance(delta); steps > 0; --steps) {
+                RunHandler(fixed_timestep_->GetStep());
+            }
+        } else {
+            RunHandler(delta);
         }
         ScheduleTick();
     }
 }
 
+void Ticker::RunHandler(std::chrono::milliseconds delta) {
+    try {
+        handler_(delta);
+    } catch (std::exception&) {
+        // Теоретически этого не должно произойти
+        // Пользователь класса Ticker должен предоставить handler, который корректно обработает все exception'ы
+        // Но если мы всё же тут оказались, то проигнорируем это исключение, учтя его в счётчике
+        ++failed_ticks_;
+    }
+}
+
 } // namespace app
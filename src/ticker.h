@@ -1,11 +1,14 @@
 #pragma once
 
+#include "fixed_timestep.h"
+
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <chrono>
 #include <functional>
 #include <memory>
+#include <optional>
 
 namespace app {
 
@@ -17,11 +20,28 @@ public:
     // Функция handler будет вызываться внутри strand с интервалом period
     Ticker(Strand strand, std::chrono::milliseconds period, Handler handler);
 
+    // Включает режим фиксированного шага: handler получает ровно period за вызов
+    // и вызывается столько раз, сколько целых периодов прошло, но не больше max_steps подряд.
+    // Вызывать до Start
+    void SetFixedTimestep(unsigned max_steps);
+
     void Start();
 
+    // Статистика режима фиксированного шага, std::nullopt - режим выключен.
+    // Читать, когда strand уже не выполняет тики
+    const std::optional<FixedTimestep>& GetFixedTimestep() const noexcept {
+        return fixed_timestep_;
+    }
+
+    // Сколько вызовов handler завершились исключением. Читать, когда strand уже не выполняет тики
+    size_t GetFailedTicks() const noexcept {
+        return failed_ticks_;
+    }
+
 private:
     void ScheduleTick();
     void OnTick(boost::system::error_code ec);
+    void RunHandler(std::chrono::milliseconds delta);
 
     using Clock = std::chrono::steady_clock;
 
@@ -30,6 +50,8 @@ private:
     boost::asio::steady_timer timer_;
     Handler handler_;
     std::chrono::steady_clock::time_point last_tick_;
+    std::optional<FixedTimestep> fixed_timestep_;
+    size_t failed_ticks_ = 0;
 };
 
 } // namespace app
@@ -0,0 +1,111 @@
+#include "websocket_session.h"
+
+using namespace std::literals;
+
+namespace http_server {
+
+WebSocketSession::WebSocketSession(Socket&& socket)
+    : ws_(std::move(socket)) {
+}
+
+void WebSocketSession::Accept(StringRequest&& request, MessageHandler on_message) {
+    net::dispatch(ws_.get_executor(), [self = shared_from_this(), request = std::move(request), on_message = std::move(on_message)]() mutable {
+        self->on_message_ = std::move(on_message);
+        self->ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+        // Запрос хранится в обработчике до конца рукопожатия
+        auto safe_request = std::make_shared<StringRequest>(std::move(request));
+        self->ws_.async_accept(*safe_request, [self, safe_request](beast::error_code ec) {
+            if (ec) {
+                self->closed_ = true;
+                return ReportError(ec, "websocket accept"sv);
+            }
+            self->open_ = true;
+            self->Read();
+            if (self->pending_) {
+                self->WriteNext();
+            }
+        });
+    });
+}
+
+void WebSocketSession::Reject(StringResponse&& response) {
+    net::dispatch(ws_.get_executor(), [self = shared_from_this(), response = std::move(response)]() mutable {
+        self->closed_ = true;
+        auto safe_response = std::make_shared<StringResponse>(std::move(response));
+        safe_response->keep_alive(false);
+        http::async_write(self->ws_.next_layer(), *safe_response, [self, safe_response](beast::error_code ec, std::size_t) {
+            if (ec) {
+                return ReportError(ec, "write"sv);
+            }
+            self->ws_.next_layer().shutdown(tcp::socket::shutdown_send, ec);
+        });
+    });
+}
+
+void WebSocketSession::Push(Frame frame) {
+    net::dispatch(ws_.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable {
+        if (self->closed_) {
+            return;
+        }
+        self->pending_ = std::move(frame);
+        if (self->open_ && !self->writing_) {
+            self->WriteNext();
+        }
+    });
+}
+
+void WebSocketSession::Close() {
+    net::dispatch(ws_.get_executor(), [self = shared_from_this()] {
+        if (self->closed_ || !self->open_) {
+            self->closed_ = true;
+            return;
+        }
+        self->closed_ = true;
+        self->pending_.reset();
+        self->ws_.async_close(websocket::close_code::normal, [self](beast::error_code ec) {
+            if (ec) {
+                ReportError(ec, "websocket close"sv);
+            }
+        });
+    });
+}
+
+void WebSocketSession::Read() {
+    ws_.async_read(buffer_, beast::bind_front_handler(&WebSocketSession::OnRead, shared_from_this()));
+}
+
+void WebSocketSession::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+    if (ec) {
+        closed_ = true;
+        // Закрытие соединения любой из сторон - нормальная ситуация
+        if (ec != websocket::error::closed && ec != net::error::operation_aborted) {
+            ReportError(ec, "websocket read"sv);
+        }
+        return;
+    }
+    if (ws_.got_text() && on_message_) {
+        on_message_(beast::buffers_to_string(buffer_.data()));
+    }
+    buffer_.consume(buffer_.size());
+    Read();
+}
+
+void WebSocketSession::WriteNext() {
+    writing_ = std::move(pending_);
+    pending_.reset();
+    ws_.text(true);
+    ws_.async_write(net::buffer(*writing_), beast::bind_front_handler(&WebSocketSession::OnWrite, shared_from_this()));
+}
+
+void WebSocketSession::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+    writing_.reset();
+    if (ec) {
+        closed_ = true;
+        return ReportError(ec, "websocket write"sv);
+    }
+    if (pending_ && !closed_) {
+        WriteNext();
+    }
+}
+
+}  // namespace http_server
@@ -0,0 +1,56 @@
+#pragma once
+#include "http_server.h"
+//
+#include <boost/beast/websocket.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace http_server {
+
+namespace websocket = beast::websocket;
+
+// Кадр для отправки. Неизменяем, поэтому один кадр можно отдать всем подписчикам сразу
+using Frame = std::shared_ptr<const std::string>;
+
+// Соединение WebSocket поверх сокета, забранного у HTTP-сессии после запроса на upgrade.
+// Все открытые методы потокобезопасны: работа переносится в strand сокета
+class WebSocketSession : public std::enable_shared_from_this<WebSocketSession> {
+public:
+    // Вызывается в strand соединения для каждого текстового сообщения клиента
+    using MessageHandler = std::function<void(std::string message)>;
+
+    explicit WebSocketSession(Socket&& socket);
+
+    WebSocketSession(const WebSocketSession&) = delete;
+    WebSocketSession& operator=(const WebSocketSession&) = delete;
+
+    // Завершает рукопожатие по запросу request и начинает читать сообщения
+    void Accept(StringRequest&& request, MessageHandler on_message);
+    // Отвечает на запрос обычным HTTP-ответом (например, 401) и закрывает соединение
+    void Reject(StringResponse&& response);
+
+    // Ставит кадр в очередь. Клиенту нужно только последнее состояние, поэтому кадр,
+    // не успевший уйти до прихода следующего, заменяется им
+    void Push(Frame frame);
+    void Close();
+
+private:
+    void Read();
+    void OnRead(beast::error_code ec, std::size_t bytes_read);
+    void WriteNext();
+    void OnWrite(beast::error_code ec, std::size_t bytes_written);
+
+    websocket::stream<Socket> ws_;
+    beast::flat_buffer buffer_;
+    MessageHandler on_message_;
+    // Кадр, который пишется сейчас, и следующий за ним
+    Frame writing_;
+    Frame pending_;
+    // Рукопожатие завершено; соединение закрыто или закрывается
+    bool open_{false};
+    bool closed_{false};
+};
+
+}  // namespace http_server
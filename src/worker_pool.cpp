@@ -0,0 +1,134 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace util {
+
+struct ParallelForJob {
+    ParallelForJob(size_t n, TaskRef fn)
+        : count{n}
+        , task{fn} {
+    }
+
+    bool HasTasks() const noexcept {
+        return next.load() < count;
+    }
+
+    // Забирает и выполняет задачи, пока они не кончатся
+    void Work() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard lock{mutex};
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            if (done.fetch_add(1) + 1 == count) {
+                done.notify_all();
+            }
+        }
+    }
+
+    void Wait() {
+        for (size_t d = done.load(); d != count; d = done.load()) {
+            done.wait(d);
+        }
+    }
+
+    const size_t count;
+    const TaskRef task;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::exception_ptr error;
+    // Сколько рабочих потоков пула взялись за этот вызов и ещё не вернулись. Меняется под мьютексом пула
+    size_t helpers{0};
+};
+
+WorkerPool::WorkerPool(unsigned threads)
+    : threads_{threads} {
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back([this] {
+            WorkerLoop();
+        });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock{mutex_};
+        stopped_ = true;
+    }
+    has_work_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkerPool::WorkerLoop() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+        // Самый вложенный вызов первым: его ждут все внешние
+        ParallelForJob* job = nullptr;
+        has_work_.wait(lock, [this, &job] {
+            const auto it = std::find_if(jobs_.rbegin(), jobs_.rend(), [](const ParallelForJob* j) {
+                return j->HasTasks();
+            });
+            job = it != jobs_.rend() ? *it : nullptr;
+            return stopped_ || job;
+        });
+        if (stopped_) {
+            return;
+        }
+
+        ++job->helpers;
+        lock.unlock();
+        job->Work();
+        lock.lock();
+        if (--job->helpers == 0) {
+            helpers_left_.notify_all();
+        }
+    }
+}
+
+void WorkerPool::ParallelFor(size_t n, TaskRef fn) {
+    if (n == 0) {
+        return;
+    }
+    ParallelForJob job{n, fn};
+    if (workers_.empty() || n == 1) {
+        job.Work();
+        if (job.error) {
+            std::rethrow_exception(job.error);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock{mutex_};
+        jobs_.push_back(&job);
+    }
+    has_work_.notify_all();
+    job.Work();
+    job.Wait();
+
+    // Помощник мог взять вызов, когда задачи уже кончались: состояние на стеке освобождается только после его ухода
+    {
+        std::unique_lock lock{mutex_};
+        jobs_.erase(std::find(jobs_.begin(), jobs_.end(), &job));
+        helpers_left_.wait(lock, [&job] {
+            return job.helpers == 0;
+        });
+    }
+
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+}  // namespace util
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace util {
+
+// Невладеющая ссылка на вызываемый объект с сигнатурой void(size_t). В отличие от std::function
+// не выделяет память под замыкание, поэтому ParallelFor можно звать из тика без выделений.
+// Объект должен жить, пока идёт вызов ParallelFor
+class TaskRef {
+public:
+    template <typename Fn>
+        requires (!std::is_same_v<std::remove_cvref_t<Fn>, TaskRef>)
+    TaskRef(Fn&& fn) noexcept  // NOLINT: неявное преобразование из лямбды
+        : object_{const_cast<void*>(static_cast<const void*>(std::addressof(fn)))}
+        , call_{[](void* object, size_t i) {
+            (*static_cast<std::remove_reference_t<Fn>*>(object))(i);
+        }} {
+    }
+
+    void operator()(size_t i) const {
+        call_(object_, i);
+    }
+
+private:
+    void* object_;
+    void (*call_)(void*, size_t);
+};
+
+struct ParallelForJob;
+
+// Пул потоков для распараллеливания шагов симуляции.
+// Вызывающий поток тоже выполняет работу, поэтому пул с threads = 0 работает последовательно.
+// Потоки пула живут всё время жизни пула и забирают работу из списка текущих вызовов ParallelFor,
+// поэтому после прогрева ParallelFor не выделяет память
+class WorkerPool {
+public:
+    // threads - число дополнительных рабочих потоков
+    explicit WorkerPool(unsigned threads);
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool();
+
+    // Сколько потоков, включая вызывающий, может одновременно выполнять работу
+    unsigned GetConcurrency() const noexcept {
+        return threads_ + 1;
+    }
+
+    // Вызывает fn(i) для каждого i из [0, n) и дожидается завершения всех вызовов.
+    // Порядок вызовов не определён. Первое выброшенное исключение передаётся вызывающему.
+    // Вызов из задачи этого же пула безопасен: ожидающий поток сам разбирает оставшуюся работу
+    void ParallelFor(size_t n, TaskRef fn);
+
+private:
+    void WorkerLoop();
+
+    unsigned threads_;
+    std::mutex mutex_;
+    // Рабочие потоки ждут появления вызова с неразобранными задачами, вызывающие - ухода помощников
+    std::condition_variable has_work_;
+    std::condition_variable helpers_left_;
+    // Незавершённые вызовы ParallelFor, вложенные идут после внешних. Состояние вызова лежит на стеке вызывающего
+    std::vector<ParallelForJob*> jobs_;
+    bool stopped_{false};
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace util
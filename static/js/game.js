@@ -164,7 +164,9 @@ class GameState {
     this.lostObjects = {};
     this.disappearingLoot = {};
     this.player_elems = {};
+    this.socket = undefined;
 
+    this._connectSocket();
     this._updateState(function() {
       self.stateLoaded = true;
       self._startGame();
@@ -183,7 +185,8 @@ class GameState {
     if (!this.started)
       return false;
 
-    if ((this.ticks % this.posUpdateInterval == 0 || this.requestInstantUpdate) && !this.updateInProgress) {
+    // The server pushes the state over the WebSocket after every tick, polling is only a fallback
+    if (!this._socketOpen() && (this.ticks % this.posUpdateInterval == 0 || this.requestInstantUpdate) && !this.updateInProgress) {
       this.requestInstantUpdate = false;
       this._updateState(function() {
         self._applyDesiredState();
@@ -212,6 +215,13 @@ class GameState {
 
   _pressKey(keys, then) {
     const self = this;
+    if (this._socketOpen()) {
+      this.socket.send(JSON.stringify({
+        move: keys
+      }));
+      then();
+      return;
+    }
     $.post({
       url: '/api/v1/game/player/action',
       dataType: 'json',
@@ -228,6 +238,33 @@ class GameState {
     })
   }
 
+  _socketOpen() {
+    return this.socket !== undefined && this.socket.readyState === WebSocket.OPEN;
+  }
+
+  _connectSocket() {
+    if (!window.WebSocket) {
+      return;
+    }
+    const self = this;
+    const scheme = location.protocol === 'https:' ? 'wss://' : 'ws://';
+    const socket = new WebSocket(scheme + location.host + '/api/v1/game/ws?token=' + encodeURIComponent(Cookies.get('authToken')));
+    socket.onmessage = function(event) {
+      self.desiredState = JSON.parse(event.data);
+      self.stateTime = performance.now();
+      if (self.started) {
+        self._applyDesiredState();
+      } else {
+        self.stateLoaded = true;
+        self._startGame();
+      }
+    };
+    socket.onclose = function() {
+      self.socket = undefined;
+    };
+    this.socket = socket;
+  }
+
   _startGame() {
     if (this.started || !this.stateLoaded || !this.playersLoaded) {
       return;
@@ -0,0 +1,81 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+thread_local std::size_t thread_allocations = 0;
+
+void* CountedAlloc(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    ++thread_allocations;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void* CountedAlignedAlloc(std::size_t size, std::align_val_t align) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    ++thread_allocations;
+    const auto alignment = static_cast<std::size_t>(align);
+    // aligned_alloc требует размер, кратный выравниванию
+    if (void* ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+}  // namespace
+
+namespace test_util {
+
+std::size_t GetAllocationCount() noexcept {
+    return allocations.load();
+}
+
+std::size_t GetThreadAllocationCount() noexcept {
+    return thread_allocations;
+}
+
+}  // namespace test_util
+
+void* operator new(std::size_t size) {
+    return CountedAlloc(size);
+}
+void* operator new[](std::size_t size) {
+    return CountedAlloc(size);
+}
+void* operator new(std::size_t size, std::align_val_t align) {
+    return CountedAlignedAlloc(size, align);
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return CountedAlignedAlloc(size, align);
+}
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+// Счётчик выделений памяти для тестов. Глобальные operator new и operator delete тестового бинарника
+// заменены в allocation_counter.cpp: они только считают вызовы и ничего больше не меняют
+namespace test_util {
+
+// Выделения во всех потоках с начала работы программы
+std::size_t GetAllocationCount() noexcept;
+
+// Выделения в вызывающем потоке
+std::size_t GetThreadAllocationCount() noexcept;
+
+}  // namespace test_util
@@ -0,0 +1,32 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/app.h"
+#include "test_config.h"
+
+using namespace std::literals;
+
+namespace {
+
+std::unique_ptr<app::Application> MakeApplication(bool randomize_spawns) {
+    return std::make_unique<app::Application>(test_util::TempGameConfig{}.GetPath(), randomize_spawns,
+        std::unique_ptr<db::Database, void(*)(db::Database*)>{nullptr, [](db::Database*) {}});
+}
+
+}  // namespace
+
+SCENARIO("Spawn points in fixed-point mode") {
+    GIVEN("an application with random spawns and fixed-point movement") {
+        auto application = MakeApplication(true);
+        application->SetFixedPointMovement(true);
+
+        WHEN("players join") {
+            THEN("their dogs start on the fixed-point grid") {
+                for (int i = 0; i < 100; ++i) {
+                    const auto& [player, token] = application->JoinGame(model::Map::Id{"map1"s}, "dog"sv);
+                    const auto pos = player->GetDog().GetPos();
+                    CHECK(pos == geom::SnapToFixed(pos));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/collision_detector.h"
+
+#include <bit>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace collision_detector;
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t ITEMS_COUNT = 64 * COLLECT_BATCH_SIZE;
+constexpr auto THROUGHPUT_DURATION = 300ms;
+
+struct Columns {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> width;
+};
+
+Columns MakeColumns() {
+    std::mt19937 rnd{6};
+    std::uniform_real_distribution<double> coord(0.0, 10.0);
+    Columns columns;
+    for (size_t i = 0; i < ITEMS_COUNT; ++i) {
+        columns.x.push_back(coord(rnd));
+        columns.y.push_back(coord(rnd));
+        columns.width.push_back(i % 5 == 0 ? 0.5 : 0.0);
+    }
+    return columns;
+}
+
+// Число подобранных предметов, чтобы компилятор не выбросил вычисления
+size_t CollectOneByOne(const Gatherer& gatherer, const Columns& items) {
+    size_t collected = 0;
+    for (size_t i = 0; i < ITEMS_COUNT; ++i) {
+        const auto result = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, {items.x[i], items.y[i]});
+        collected += result.IsCollected(gatherer.width + items.width[i]);
+    }
+    return collected;
+}
+
+size_t CollectInBatches(const Gatherer& gatherer, const Columns& items, SimdLevel level) {
+    BatchCollectionResult result;
+    size_t collected = 0;
+    for (size_t first = 0; first < ITEMS_COUNT; first += COLLECT_BATCH_SIZE) {
+        const ItemBatch batch{std::span{items.x}.subspan(first, COLLECT_BATCH_SIZE),
+                              std::span{items.y}.subspan(first, COLLECT_BATCH_SIZE),
+                              std::span{items.width}.subspan(first, COLLECT_BATCH_SIZE)};
+        TryCollectPoints(gatherer, batch, result, level);
+        collected += std::popcount(result.collected);
+    }
+    return collected;
+}
+
+// Catch2 сообщает время одного прогона, пропускная способность считается отдельно
+template <typename Fn>
+void ReportThroughput(std::string_view name, Fn&& fn) {
+    using Clock = std::chrono::steady_clock;
+    size_t runs = 0;
+    size_t collected = 0;
+    const auto start = Clock::now();
+    auto elapsed = Clock::duration{};
+    while (elapsed < THROUGHPUT_DURATION) {
+        collected += fn();
+        ++runs;
+        elapsed = Clock::now() - start;
+    }
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    std::cout << name << ": " << static_cast<double>(runs * ITEMS_COUNT) / seconds / 1e6 << " M items/s"
+              << " (" << collected / runs << " collected per run)" << std::endl;
+}
+
+}  // namespace
+
+TEST_CASE("Batch TryCollectPoint: items per second", "[!benchmark]") {
+    const auto items = MakeColumns();
+    const Gatherer gatherer{{2.0, 5.0}, {8.0, 5.0}, 0.6};
+
+    std::vector<std::pair<SimdLevel, std::string>> levels{{SimdLevel::SCALAR, "scalar"s}};
+    if (GetSimdLevel() >= SimdLevel::SSE2) {
+        levels.emplace_back(SimdLevel::SSE2, "sse2"s);
+    }
+    if (GetSimdLevel() >= SimdLevel::AVX2) {
+        levels.emplace_back(SimdLevel::AVX2, "avx2"s);
+    }
+
+    const auto suffix = ": "s + std::to_string(ITEMS_COUNT) + " items"s;
+    BENCHMARK("TryCollectPoint one by one" + suffix) {
+        return CollectOneByOne(gatherer, items);
+    };
+    ReportThroughput("TryCollectPoint one by one"sv, [&] {
+        return CollectOneByOne(gatherer, items);
+    });
+
+    for (const auto& [level, name] : levels) {
+        BENCHMARK("TryCollectPoints " + name + suffix) {
+            return CollectInBatches(gatherer, items, level);
+        };
+        ReportThroughput("TryCollectPoints " + name, [&, level = level] {
+            return CollectInBatches(gatherer, items, level);
+        });
+    }
+}
@@ -0,0 +1,223 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/collision_detector.h"
+
+#include <random>
+
+using namespace collision_detector;
+
+namespace {
+
+struct Scene {
+    std::vector<Item> items;
+    std::vector<Gatherer> gatherers;
+};
+
+class TestProvider : public ItemGathererProvider {
+public:
+    explicit TestProvider(const Scene& scene)
+        : scene_{scene} {
+    }
+
+    size_t ItemsCount() const override {
+        return scene_.items.size();
+    }
+    Item GetItem(size_t idx) const override {
+        return scene_.items.at(idx);
+    }
+    size_t GatherersCount() const override {
+        return scene_.gatherers.size();
+    }
+    Gatherer GetGatherer(size_t idx) const override {
+        return scene_.gatherers.at(idx);
+    }
+
+private:
+    const Scene& scene_;
+};
+
+// Собиратели ходят по сетке дорог шагами по 0.5, поэтому время событий часто совпадает
+Scene MakeRandomScene(std::mt19937& rnd, size_t items_count, size_t gatherers_count) {
+    std::uniform_int_distribution<int> coord(0, 20);
+    std::uniform_int_distribution<int> step(-2, 2);
+    Scene scene;
+    for (size_t i = 0; i < items_count; ++i) {
+        scene.items.push_back({{coord(rnd) * 0.5, coord(rnd) * 0.5}, i % 5 == 0 ? 0.5 : 0.0});
+    }
+    for (size_t i = 0; i < gatherers_count; ++i) {
+        geom::Point2D start{coord(rnd) * 0.5, coord(rnd) * 0.5};
+        geom::Point2D end = start;
+        (i % 2 ? end.x : end.y) += step(rnd) * 0.5;
+        scene.gatherers.push_back({start, end, 0.6});
+    }
+    return scene;
+}
+
+void CheckSameEvents(const std::vector<GatheringEvent>& actual, const std::vector<GatheringEvent>& expected) {
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        CHECK(actual[i].item_id == expected[i].item_id);
+        CHECK(actual[i].gatherer_id == expected[i].gatherer_id);
+        CHECK(actual[i].sq_distance == expected[i].sq_distance);
+        CHECK(actual[i].time == expected[i].time);
+    }
+}
+
+}  // namespace
+
+SCENARIO("Parallel gather events search") {
+    GIVEN("random items and gatherers") {
+        std::mt19937 rnd{1};
+        util::WorkerPool pool{3};
+        GatherScratch scratch;
+        std::vector<GatheringEvent> expected;
+        std::vector<GatheringEvent> actual;
+
+        THEN("events and their order match the serial search") {
+            for (int iteration = 0; iteration < 50; ++iteration) {
+                const auto scene = MakeRandomScene(rnd, 40, 300);
+                FindGatherEventsBruteForce(scene.items, scene.gatherers, expected);
+                for (size_t chunk_size : {1, 7, 64, 1000}) {
+                    FindGatherEvents(scene.items, scene.gatherers, actual, scratch, pool, chunk_size);
+                    CheckSameEvents(actual, expected);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Gather events search with a grid") {
+    GIVEN("random items and gatherers") {
+        std::mt19937 rnd{2};
+        GatherScratch scratch;
+        std::vector<GatheringEvent> expected;
+        std::vector<GatheringEvent> actual;
+
+        THEN("events and their order match the brute force search") {
+            for (int iteration = 0; iteration < 50; ++iteration) {
+                for (size_t items_count : {0, 1, 5, 40, 300}) {
+                    const auto scene = MakeRandomScene(rnd, items_count, 200);
+                    FindGatherEventsBruteForce(scene.items, scene.gatherers, expected);
+                    FindGatherEventsWithGrid(scene.items, scene.gatherers, actual, scratch);
+                    CheckSameEvents(actual, expected);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Gather events search through ItemGathererProvider") {
+    GIVEN("random items and gatherers behind a provider") {
+        std::mt19937 rnd{3};
+        const auto scene = MakeRandomScene(rnd, 40, 300);
+
+        THEN("events match the search over arrays") {
+            std::vector<GatheringEvent> expected;
+            FindGatherEventsBruteForce(scene.items, scene.gatherers, expected);
+            CheckSameEvents(FindGatherEvents(TestProvider{scene}), expected);
+        }
+    }
+}
+
+SCENARIO("Gather events search on road lines") {
+    GIVEN("random items on road lines, at crossings and off the lines") {
+        std::mt19937 rnd{4};
+        util::WorkerPool pool{3};
+        GatherScratch scratch;
+        std::vector<GatheringEvent> expected;
+        std::vector<GatheringEvent> actual;
+
+        THEN("events and their order match the brute force search") {
+            for (int iteration = 0; iteration < 50; ++iteration) {
+                for (size_t items_count : {0, 1, 5, 40, 300}) {
+                    const auto scene = MakeRandomScene(rnd, items_count, 200);
+                    FindGatherEventsBruteForce(scene.items, scene.gatherers, expected);
+                    FindGatherEventsOnRoadLines(scene.items, scene.gatherers, actual, scratch);
+                    CheckSameEvents(actual, expected);
+                    FindGatherEvents(scene.items, scene.gatherers, actual, scratch, pool, 64, GatherMode::ROAD_LINES);
+                    CheckSameEvents(actual, expected);
+                }
+            }
+        }
+    }
+
+    GIVEN("a dog walking along a horizontal road") {
+        const std::vector<Item> items{
+            {{2.0, 1.0}, 0.0},  // на пути
+            {{5.0, 1.0}, 0.0},  // за концом пути
+            {{3.0, 1.5}, 0.0},  // на вертикальной линии рядом с путём
+            {{3.0, 2.0}, 0.0},  // на соседней горизонтальной линии, слишком далеко
+            {{1.0, 2.0}, 0.5},  // база на соседней линии
+        };
+        const std::vector<Gatherer> gatherers{{{0.0, 1.2}, {4.0, 1.2}, 0.6}};
+        GatherScratch scratch;
+        std::vector<GatheringEvent> expected;
+        std::vector<GatheringEvent> actual;
+
+        THEN("only items within reach of the path are gathered") {
+            FindGatherEventsBruteForce(items, gatherers, expected);
+            FindGatherEventsOnRoadLines(items, gatherers, actual, scratch);
+            CheckSameEvents(actual, expected);
+            REQUIRE(actual.size() == 3);
+            CHECK(actual[0].item_id == 4);
+            CHECK(actual[1].item_id == 0);
+            CHECK(actual[2].item_id == 2);
+        }
+    }
+}
+
+SCENARIO("Batch TryCollectPoint") {
+    GIVEN("gatherers and batches of items in columns") {
+        std::mt19937 rnd{5};
+        // Координаты кратны 0.1, поэтому часть предметов лежит ровно на границе радиуса или концах отрезка
+        std::uniform_int_distribution<int> coord(0, 40);
+        std::uniform_int_distribution<int> step(-10, 10);
+        std::uniform_int_distribution<int> width(0, 6);
+
+        std::vector<SimdLevel> levels{SimdLevel::SCALAR};
+        if (GetSimdLevel() >= SimdLevel::SSE2) {
+            levels.push_back(SimdLevel::SSE2);
+        }
+        if (GetSimdLevel() >= SimdLevel::AVX2) {
+            levels.push_back(SimdLevel::AVX2);
+        }
+
+        THEN("every implementation makes the same decisions as TryCollectPoint") {
+            std::vector<double> xs, ys, widths;
+            BatchCollectionResult result;
+            for (int iteration = 0; iteration < 500; ++iteration) {
+                // Стоящий собиратель тоже проверяется: скалярный код получает NaN и ничего не подбирает
+                geom::Point2D start{coord(rnd) * 0.1, coord(rnd) * 0.1};
+                geom::Point2D end = start;
+                (iteration % 2 ? end.x : end.y) += step(rnd) * 0.1;
+                const Gatherer gatherer{start, end, width(rnd) * 0.1};
+
+                const size_t count = iteration % (COLLECT_BATCH_SIZE + 1);
+                xs.clear();
+                ys.clear();
+                widths.clear();
+                for (size_t i = 0; i < count; ++i) {
+                    xs.push_back(coord(rnd) * 0.1);
+                    ys.push_back(coord(rnd) * 0.1);
+                    widths.push_back(width(rnd) * 0.1);
+                }
+
+                for (const auto level : levels) {
+                    TryCollectPoints(gatherer, {xs, ys, widths}, result, level);
+                    for (size_t i = 0; i < count; ++i) {
+                        const auto expected = TryCollectPoint(start, end, {xs[i], ys[i]});
+                        const bool collected = expected.IsCollected(gatherer.width + widths[i]);
+                        REQUIRE(((result.collected >> i) & 1) == collected);
+                        if (collected) {
+                            CHECK(result.sq_distance[i] == expected.sq_distance);
+                            CHECK(result.proj_ratio[i] == expected.proj_ratio);
+                        }
+                    }
+                    if (count < COLLECT_BATCH_SIZE) {
+                        REQUIRE((result.collected >> count) == 0);
+                    }
+                }
+            }
+        }
+    }
+}
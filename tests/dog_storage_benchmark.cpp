@@ -0,0 +1,145 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/collision_detector.h"
+#include "../src/json_loader.h"
+#include "../src/model.h"
+
+#include <random>
+
+using namespace model;
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t DOG_COUNT = 10'000;
+constexpr auto TICK = 20ms;
+
+std::vector<Dog> MakeDogs(const Map& map) {
+    std::mt19937 rnd{7};
+    std::uniform_int_distribution<size_t> road_dist(0, map.GetRoads().size() - 1);
+    std::vector<Dog> dogs;
+    dogs.reserve(DOG_COUNT);
+    for (size_t i = 0; i < DOG_COUNT; ++i) {
+        const auto& road = map.GetRoads()[road_dist(rnd)];
+        std::uniform_real_distribution<double> x_dist(std::min(road.GetStart().x, road.GetEnd().x), std::max(road.GetStart().x, road.GetEnd().x));
+        std::uniform_real_distribution<double> y_dist(std::min(road.GetStart().y, road.GetEnd().y), std::max(road.GetStart().y, road.GetEnd().y));
+        const auto speed = map.GetDogSpeed();
+        const geom::Vec2D vel = road.IsHorizontal() ? geom::Vec2D{i % 2 ? speed : -speed, 0} : geom::Vec2D{0, i % 2 ? speed : -speed};
+        Dog dog{"dog"sv, {x_dist(rnd), y_dist(rnd)}, vel, map.GetBagCapacity(), i};
+        dog.SetIdle(false);
+        dogs.push_back(std::move(dog));
+    }
+    return dogs;
+}
+
+// Собака, упёршаяся в край дороги, разворачивается, чтобы все собаки оставались в движении
+geom::Vec2D Reverse(geom::Vec2D vel_before) {
+    return {-vel_before.x, -vel_before.y};
+}
+
+}  // namespace
+
+TEST_CASE("Dog tick loop: heap-allocated dogs vs DogTable", "[!benchmark]") {
+    const auto game = json_loader::LoadGame(GAME_CONFIG_FILE);
+    const Map& map = game.GetMaps().back();
+    const auto dogs = MakeDogs(map);
+    const auto max_idle = game.GetMaxIdleTime();
+
+    // Прежнее хранение: каждая собака в куче за shared_ptr в unordered_map
+    std::unordered_map<size_t, std::shared_ptr<Dog>> heap_dogs;
+    for (const auto& dog : dogs) {
+        heap_dogs.emplace(dog.GetId(), std::make_shared<Dog>(dog));
+    }
+
+    DogTable table;
+    for (const auto& dog : dogs) {
+        table.Add(dog);
+    }
+
+    std::vector<std::pair<Dog*, collision_detector::Gatherer>> heap_gatherers;
+    std::vector<std::pair<DogTable::Slot, collision_detector::Gatherer>> table_gatherers;
+
+    BENCHMARK("shared_ptr<Dog> in unordered_map") {
+        heap_gatherers.clear();
+        for (auto& [id, dog] : heap_dogs) {
+            if (dog->GetIdleFor() >= max_idle) {
+                continue;
+            }
+            dog->SetAge(dog->GetAge() + TICK);
+            if (dog->IsIdle()) {
+                dog->SetIdleFor(dog->GetIdleFor() + TICK);
+            } else {
+                dog->SetIdleFor(0ms);
+            }
+            const auto old_pos = dog->GetPos();
+            const auto old_vel = dog->GetVelocity();
+            map.MoveDog(dog.get(), TICK);
+            if (dog->IsIdle()) {
+                dog->SetIdle(false);
+                dog->SetVelocity(Reverse(old_vel));
+            }
+            heap_gatherers.emplace_back(dog.get(), collision_detector::Gatherer{old_pos, dog->GetPos(), 0.6});
+        }
+        return heap_gatherers.size();
+    };
+
+    BENCHMARK("DogTable columns") {
+        table_gatherers.clear();
+        // возраст и простой вычисляются от времени таблицы, обходятся только движущиеся собаки
+        table.AdvanceTime(TICK);
+        auto positions = table.GetPositions();
+        auto velocities = table.GetVelocities();
+        for (const auto slot : table.GetActive()) {
+            const auto old_pos = positions[slot];
+            const auto old_vel = velocities[slot];
+            if (map.MoveDog(positions[slot], velocities[slot], TICK)) {
+                velocities[slot] = Reverse(old_vel);
+            }
+            table_gatherers.emplace_back(slot, collision_detector::Gatherer{old_pos, positions[slot], 0.6});
+        }
+        return table_gatherers.size();
+    };
+}
+
+TEST_CASE("MoveDog: double vs fixed point", "[!benchmark]") {
+    const auto game = json_loader::LoadGame(GAME_CONFIG_FILE);
+    const Map& map = game.GetMaps().back();
+    const auto dogs = MakeDogs(map);
+
+    std::vector<geom::Point2D> positions;
+    std::vector<geom::Vec2D> velocities;
+    std::vector<geom::FixedPoint2D> fixed_positions;
+    std::vector<geom::FixedVec2D> fixed_velocities;
+    std::vector<int64_t> remainders(dogs.size(), 0);
+    for (const auto& dog : dogs) {
+        positions.push_back(dog.GetPos());
+        velocities.push_back(dog.GetVelocity());
+        fixed_positions.push_back(geom::ToFixed(dog.GetPos()));
+        fixed_velocities.push_back(geom::ToFixed(dog.GetVelocity()));
+    }
+
+    BENCHMARK("double") {
+        size_t stopped = 0;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            const auto old_vel = velocities[i];
+            if (map.MoveDog(positions[i], velocities[i], TICK)) {
+                velocities[i] = Reverse(old_vel);
+                ++stopped;
+            }
+        }
+        return stopped;
+    };
+
+    BENCHMARK("fixed point") {
+        size_t stopped = 0;
+        for (size_t i = 0; i < fixed_positions.size(); ++i) {
+            const auto old_vel = fixed_velocities[i];
+            if (map.MoveDog(fixed_positions[i], fixed_velocities[i], TICK, remainders[i])) {
+                fixed_velocities[i] = {-old_vel.x, -old_vel.y};
+                ++stopped;
+            }
+        }
+        return stopped;
+    };
+}
@@ -0,0 +1,203 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model.h"
+
+using namespace model;
+using namespace std::literals;
+
+SCENARIO("Dog table") {
+    GIVEN("a table with three dogs") {
+        DogTable dogs;
+        for (size_t id : {10, 20, 30}) {
+            Dog dog{"dog"s + std::to_string(id), {static_cast<double>(id), 0.0}, {1.0, 0.0}, id / 10, id};
+            dog.SetScore(id);
+            dogs.Add(dog);
+        }
+
+        THEN("dogs are found by id") {
+            REQUIRE(dogs.Size() == 3);
+            for (size_t id : {10, 20, 30}) {
+                auto slot = dogs.FindSlot(id);
+                REQUIRE(slot);
+                CHECK(dogs[*slot].GetId() == id);
+                CHECK(dogs[*slot].GetScore() == id);
+                CHECK(dogs[*slot].GetName() == "dog"s + std::to_string(id));
+            }
+            CHECK_FALSE(dogs.FindSlot(40));
+        }
+
+        WHEN("items are grabbed") {
+            auto dog = dogs[*dogs.FindSlot(20)];
+            CHECK(dog.TryGrabItem(1, 5));
+            CHECK(dog.TryGrabItem(2, 6));
+
+            THEN("the bag is limited by the dog's capacity") {
+                CHECK_FALSE(dog.TryGrabItem(3, 7));
+                CHECK(dog.GetBag().size() == 2);
+                CHECK(dogs[*dogs.FindSlot(10)].GetBag().empty());
+            }
+
+            AND_WHEN("a dog with a bigger bag is added") {
+                dogs.Add(Dog{"big"sv, {}, {}, 8, 80});
+
+                THEN("existing bags are kept") {
+                    auto moved = dogs[*dogs.FindSlot(20)];
+                    REQUIRE(moved.GetBag().size() == 2);
+                    CHECK(moved.GetBag()[0] == DogTable::BagItem{1, 5});
+                    CHECK(moved.GetBag()[1] == DogTable::BagItem{2, 6});
+                }
+            }
+        }
+
+        WHEN("a dog is removed") {
+            dogs[*dogs.FindSlot(30)].TryGrabItem(7, 1);
+            REQUIRE(dogs.Remove(10));
+
+            THEN("the remaining dogs keep their state") {
+                CHECK(dogs.Size() == 2);
+                CHECK_FALSE(dogs.FindSlot(10));
+                CHECK_FALSE(dogs.Remove(10));
+
+                auto dog = dogs[*dogs.FindSlot(30)];
+                CHECK(dog.GetPos() == geom::Point2D{30.0, 0.0});
+                CHECK(dog.GetScore() == 30);
+                CHECK(dog.GetBag().size() == 1);
+
+                const auto extracted = dogs.Extract(dog.GetSlot());
+                CHECK(extracted.GetId() == 30);
+                CHECK(extracted.GetBag() == std::vector<DogTable::BagItem>{{7, 1}});
+            }
+        }
+    }
+}
+
+SCENARIO("Active dogs and idle time") {
+    GIVEN("a table with a moving and a standing dog") {
+        DogTable dogs;
+        Dog moving{"moving"sv, {}, {1.0, 0.0}, 3, 1};
+        moving.SetIdle(false);
+        dogs.Add(moving);
+        dogs.Add(Dog{"standing"sv, {}, {}, 3, 2});
+
+        THEN("only the moving dog is active") {
+            REQUIRE(dogs.GetActive().size() == 1);
+            CHECK(dogs.GetId(dogs.GetActive()[0]) == 1);
+        }
+
+        WHEN("session time advances") {
+            dogs.AdvanceTime(300ms);
+
+            THEN("age grows for every dog and idle time only for the standing one") {
+                auto moving_dog = dogs[*dogs.FindSlot(1)];
+                auto standing_dog = dogs[*dogs.FindSlot(2)];
+                CHECK(moving_dog.GetAge() == 300ms);
+                CHECK(moving_dog.GetIdleFor() == 0ms);
+                CHECK(standing_dog.GetAge() == 300ms);
+                CHECK(standing_dog.GetIdleFor() == 300ms);
+            }
+
+            THEN("dogs idle for long enough are collected once") {
+                std::vector<size_t> expired;
+                dogs.CollectExpired(400ms, expired);
+                CHECK(expired.empty());
+                dogs.AdvanceTime(100ms);
+                dogs.CollectExpired(400ms, expired);
+                CHECK(expired == std::vector<size_t>{2});
+                dogs.AdvanceTime(100ms);
+                dogs.CollectExpired(400ms, expired);
+                CHECK(expired == std::vector<size_t>{2});
+            }
+
+            AND_WHEN("the dogs swap their states") {
+                dogs[*dogs.FindSlot(1)].SetIdle(true);
+                dogs[*dogs.FindSlot(2)].SetIdle(false);
+                dogs.AdvanceTime(100ms);
+
+                THEN("active set and idle times follow") {
+                    REQUIRE(dogs.GetActive().size() == 1);
+                    CHECK(dogs.GetId(dogs.GetActive()[0]) == 2);
+                    CHECK(dogs[*dogs.FindSlot(1)].GetIdleFor() == 100ms);
+                    CHECK(dogs[*dogs.FindSlot(2)].GetIdleFor() == 0ms);
+
+                    std::vector<size_t> expired;
+                    dogs.AdvanceTime(300ms);
+                    dogs.CollectExpired(400ms, expired);
+                    CHECK(expired == std::vector<size_t>{1});
+                }
+            }
+
+            AND_WHEN("the moving dog is removed") {
+                dogs.Add(Dog{"third"sv, {}, {}, 3, 3});
+                dogs[*dogs.FindSlot(3)].SetIdle(false);
+                REQUIRE(dogs.Remove(1));
+
+                THEN("the active set points to the moved slot") {
+                    REQUIRE(dogs.GetActive().size() == 1);
+                    CHECK(dogs.GetId(dogs.GetActive()[0]) == 3);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Dog trajectories") {
+    GIVEN("a dog walking east towards a stop at x = 10") {
+        DogTable dogs;
+        Dog dog{"dog"sv, {0.0, 0.0}, {2.0, 0.0}, 3, 1};
+        dog.SetIdle(false);
+        const auto slot = dogs.Add(dog);
+        dogs.SetTrajectory(slot, {10.0, 0.0}, 5000ms);
+
+        WHEN("time advances") {
+            dogs.AdvanceTime(1500ms);
+
+            THEN("the position follows the trajectory without touching the column") {
+                CHECK(dogs.GetPos(slot) == geom::Point2D{3.0, 0.0});
+                CHECK(dogs.GetPosAt(slot, 500ms) == geom::Point2D{1.0, 0.0});
+                CHECK(dogs[slot].GetPos() == geom::Point2D{3.0, 0.0});
+                CHECK(dogs.GetPositions()[slot] == geom::Point2D{0.0, 0.0});
+                CHECK(dogs.Extract(slot).GetPos() == geom::Point2D{3.0, 0.0});
+            }
+
+            THEN("no stop is reported before the end of the trajectory") {
+                std::vector<DogTable::Slot> stopped;
+                dogs.CollectStops(stopped);
+                CHECK(stopped.empty());
+            }
+
+            AND_WHEN("the dog turns around") {
+                dogs[slot].SetVelocity({-2.0, 0.0});
+
+                THEN("its position is materialized and the old stop is dropped") {
+                    CHECK_FALSE(dogs.HasTrajectory(slot));
+                    CHECK(dogs.GetPositions()[slot] == geom::Point2D{3.0, 0.0});
+
+                    std::vector<DogTable::Slot> stopped;
+                    dogs.AdvanceTime(5000ms);
+                    dogs.CollectStops(stopped);
+                    CHECK(stopped.empty());
+                    CHECK(dogs.GetVelocities()[slot] == geom::Vec2D{-2.0, 0.0});
+                }
+            }
+        }
+
+        WHEN("the dog reaches the end of the trajectory") {
+            dogs.AdvanceTime(6000ms);
+            std::vector<DogTable::Slot> stopped;
+            dogs.CollectStops(stopped);
+
+            THEN("it stops at the stop point once and idles since the stop") {
+                REQUIRE(stopped == std::vector<DogTable::Slot>{slot});
+                CHECK(dogs.GetPositions()[slot] == geom::Point2D{10.0, 0.0});
+                CHECK(dogs.GetVelocities()[slot] == geom::Vec2D{});
+                CHECK_FALSE(dogs.HasTrajectory(slot));
+                CHECK(dogs.GetActive().empty());
+                CHECK(dogs.GetIdleFor(slot) == 1000ms);
+
+                stopped.clear();
+                dogs.CollectStops(stopped);
+                CHECK(stopped.empty());
+            }
+        }
+    }
+}
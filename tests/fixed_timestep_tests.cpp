@@ -0,0 +1,34 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/fixed_timestep.h"
+
+using namespace std::literals;
+
+SCENARIO("Fixed timestep accumulation") {
+    GIVEN("a 20ms step limited to 3 steps per advance") {
+        app::FixedTimestep timestep{20ms, 3};
+
+        THEN("time is spent in whole steps and the remainder is carried over") {
+            CHECK(timestep.Advance(15ms) == 0);
+            CHECK(timestep.Advance(15ms) == 1);
+            CHECK(timestep.Advance(30ms) == 2);
+            CHECK(timestep.Advance(20ms) == 1);
+            CHECK(timestep.GetOverruns() == 0);
+            CHECK(timestep.GetDroppedTime() == 0ms);
+        }
+
+        WHEN("a long stall happens") {
+            const auto steps = timestep.Advance(1010ms);
+
+            THEN("only 3 steps are run and the rest of whole steps is dropped") {
+                CHECK(steps == 3);
+                CHECK(timestep.GetOverruns() == 1);
+                CHECK(timestep.GetDroppedTime() == 940ms);
+            }
+
+            THEN("the remainder below one step is kept") {
+                CHECK(timestep.Advance(10ms) == 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,260 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model.h"
+
+#include <algorithm>
+
+using namespace model;
+using namespace std::literals;
+
+namespace {
+
+Game MakeGame(size_t max_players_per_session) {
+    Game game;
+    Map map{Map::Id{"map1"s}, "Map 1"s, 1.0, ExtraData{{}}, 3};
+    map.AddRoad(Road{Road::HORIZONTAL, geom::Point{0, 0}, 10});
+    game.AddMap(std::move(map));
+    game.SetMaxPlayersPerSession(max_players_per_session);
+    return game;
+}
+
+GameSessionPtr Join(Game& game) {
+    GameSessionPtr session = game.GetSession(Map::Id{"map1"s}).value().get();
+    session->CreateDog("dog"sv, {0.0, 0.0});
+    return session;
+}
+
+}  // namespace
+
+SCENARIO("Session instances of a map") {
+    GIVEN("a game limited to 2 players per session") {
+        auto game = MakeGame(2);
+
+        WHEN("5 players join the map") {
+            for (int i = 0; i < 5; ++i) {
+                Join(game);
+            }
+
+            THEN("they are spread over 3 instances") {
+                const auto& sessions = game.GetSessions().at(Map::Id{"map1"s});
+                REQUIRE(sessions.size() == 3);
+                for (size_t i = 0; i < sessions.size(); ++i) {
+                    CHECK(sessions[i]->GetInstance() == i);
+                    CHECK(game.FindSession(Map::Id{"map1"s}, i).value().get() == sessions[i]);
+                }
+                CHECK(sessions[0]->GetDogs().Size() == 2);
+                CHECK(sessions[1]->GetDogs().Size() == 2);
+                CHECK(sessions[2]->GetDogs().Size() == 1);
+                CHECK_FALSE(game.FindSession(Map::Id{"map1"s}, 3));
+            }
+
+            AND_WHEN("a player leaves a full instance") {
+                auto& first = game.GetSessions().at(Map::Id{"map1"s}).front();
+                first->RemoveDog(first->GetDogs().GetId(0));
+
+                THEN("the next player joins the least loaded instance") {
+                    CHECK(Join(game) == first);
+                    CHECK(game.GetSessions().at(Map::Id{"map1"s}).size() == 3);
+                }
+            }
+        }
+    }
+
+    GIVEN("a game without the limit") {
+        auto game = MakeGame(0);
+
+        THEN("all players join the same instance") {
+            const auto session = Join(game);
+            for (int i = 0; i < 10; ++i) {
+                CHECK(Join(game) == session);
+            }
+        }
+    }
+}
+
+SCENARIO("Release of empty sessions") {
+    GIVEN("a game with 3 single-player instances and a 1 second lifetime of empty sessions") {
+        auto game = MakeGame(1);
+        game.SetEmptySessionLifetime(1000ms);
+        const auto first = Join(game);
+        const auto second = Join(game);
+        const auto third = Join(game);
+
+        WHEN("the player of the second instance leaves") {
+            second->RemoveDog(second->GetDogs().GetId(0));
+
+            THEN("the instance lives through the grace period") {
+                CHECK(game.ReleaseEmptySessions(600ms) == 0);
+                CHECK(game.GetSessions().at(Map::Id{"map1"s}).size() == 3);
+                CHECK(second->GetEmptyFor() == 600ms);
+            }
+
+            THEN("it is released afterwards and later instances are renumbered") {
+                game.ReleaseEmptySessions(600ms);
+                CHECK(game.ReleaseEmptySessions(600ms) == 1);
+                const auto& sessions = game.GetSessions().at(Map::Id{"map1"s});
+                REQUIRE(sessions.size() == 2);
+                CHECK(sessions[0] == first);
+                CHECK(sessions[1] == third);
+                CHECK(third->GetInstance() == 1);
+                CHECK(game.FindSession(Map::Id{"map1"s}, 1).value().get() == third);
+            }
+
+            THEN("a player joining during the grace period wakes the instance up") {
+                game.ReleaseEmptySessions(600ms);
+                CHECK(Join(game) == second);
+                CHECK(game.ReleaseEmptySessions(600ms) == 0);
+                CHECK(second->GetEmptyFor() == 0ms);
+            }
+        }
+
+        WHEN("all players leave") {
+            for (const auto& session : {first, second, third}) {
+                session->RemoveDog(session->GetDogs().GetId(0));
+            }
+            CHECK(game.ReleaseEmptySessions(1000ms) == 3);
+
+            THEN("the map has no sessions until the next player joins") {
+                CHECK_FALSE(game.GetSessions().contains(Map::Id{"map1"s}));
+                const auto session = Join(game);
+                CHECK(session->GetInstance() == 0);
+                CHECK(game.GetSessions().at(Map::Id{"map1"s}).size() == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Loot index of a session") {
+    GIVEN("a session with loot spread along the road") {
+        auto game = MakeGame(0);
+        GameSessionPtr session = game.GetSession(Map::Id{"map1"s}).value().get();
+        session->AddLoot({0, {1.0, 0.0}});
+        session->AddLoot({1, {9.0, 0.0}});
+        session->AddLoot({0, {9.5, 0.2}});
+
+        auto query = [&](geom::Point2D min, geom::Point2D max) {
+            std::vector<size_t> ids;
+            session->GetLootIndex().Query(min, max, ids);
+            std::sort(ids.begin(), ids.end());
+            return ids;
+        };
+
+        THEN("queries return loot from nearby cells only") {
+            CHECK(session->GetLootIndex().Size() == 3);
+            CHECK(query({0.5, -0.5}, {1.5, 0.5}) == std::vector<size_t>{1});
+            CHECK(query({8.5, -0.5}, {9.5, 0.5}) == std::vector<size_t>{2, 3});
+            CHECK(query({-1.0, -0.5}, {10.0, 0.5}) == std::vector<size_t>{1, 2, 3});
+        }
+
+        WHEN("loot is picked up") {
+            session->RemoveLoot(2);
+            session->RemoveLoot(2);
+
+            THEN("it disappears from the index") {
+                CHECK(session->GetLootIndex().Size() == 2);
+                CHECK(session->GetLoot().size() == 2);
+                CHECK(query({8.5, -0.5}, {9.5, 0.5}) == std::vector<size_t>{3});
+            }
+        }
+
+        WHEN("loot with an existing id is added again") {
+            session->AddLoot({1, {1.0, 0.0}}, 1);
+
+            THEN("the index is not duplicated") {
+                CHECK(session->GetLootIndex().Size() == 3);
+                CHECK(query({0.5, -0.5}, {1.5, 0.5}) == std::vector<size_t>{1});
+            }
+        }
+    }
+}
+
+SCENARIO("State version of a session") {
+    GIVEN("a session with one dog") {
+        auto game = MakeGame(0);
+        const auto session = Join(game);
+        const auto version = session->GetVersion();
+
+        WHEN("another dog joins") {
+            Join(game);
+
+            THEN("the version grows") {
+                CHECK(session->GetVersion() > version);
+            }
+        }
+
+        WHEN("the dog leaves") {
+            session->RemoveDog(session->GetDogs().GetId(0));
+
+            THEN("the version grows") {
+                CHECK(session->GetVersion() > version);
+            }
+        }
+
+        WHEN("nothing changes") {
+            THEN("the version stays the same") {
+                CHECK(session->GetVersion() == version);
+            }
+        }
+    }
+}
+
+SCENARIO("Random points on a map") {
+    GIVEN("a map with a long and a short road and a point-sized road") {
+        Map map{Map::Id{"map1"s}, "Map 1"s, 1.0, ExtraData{{}}, 3};
+        map.AddRoad(Road{Road::HORIZONTAL, geom::Point{0, 0}, 30});
+        map.AddRoad(Road{Road::VERTICAL, geom::Point{40, 0}, 10});
+        map.AddRoad(Road{Road::VERTICAL, geom::Point{50, 5}, 5});
+        map.BuildRoadSampler();
+
+        THEN("points lie on the roads with frequency proportional to road length") {
+            util::CounterRandom random{1};
+            constexpr int samples = 40'000;
+            int on_long_road = 0;
+            for (int i = 0; i < samples; ++i) {
+                const auto pos = map.GetRandomPoint(random);
+                if (pos.y == 0.0 && pos.x >= 0.0 && pos.x <= 30.0) {
+                    ++on_long_road;
+                } else {
+                    REQUIRE(pos.x == 40.0);
+                    REQUIRE(pos.y >= 0.0);
+                    REQUIRE(pos.y <= 10.0);
+                }
+            }
+            CHECK(std::abs(on_long_road - samples * 3 / 4) < samples / 100);
+        }
+    }
+
+    GIVEN("two games with the same seed") {
+        auto game1 = MakeGame(1);
+        auto game2 = MakeGame(1);
+        game1.SetRandomSeed(42);
+        game2.SetRandomSeed(42);
+
+        THEN("their sessions produce the same points, and instances get different streams") {
+            auto first1 = Join(game1);
+            auto first2 = Join(game2);
+            auto second1 = Join(game1);
+            const auto* map = first1->GetMap();
+            for (int i = 0; i < 10; ++i) {
+                const auto pos = map->GetRandomPoint(first1->GetRandom());
+                CHECK(pos == map->GetRandomPoint(first2->GetRandom()));
+                CHECK(pos != map->GetRandomPoint(second1->GetRandom()));
+            }
+        }
+    }
+
+    GIVEN("a random stream") {
+        util::CounterRandom random{7};
+        for (int i = 0; i < 5; ++i) {
+            random();
+        }
+
+        THEN("it can be resumed from its seed and counter") {
+            util::CounterRandom copy{random.GetSeed()};
+            copy.SetCounter(random.GetCounter());
+            for (int i = 0; i < 5; ++i) {
+                CHECK(copy() == random());
+            }
+        }
+    }
+}
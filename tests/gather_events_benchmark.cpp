@@ -0,0 +1,104 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/collision_detector.h"
+
+#include <random>
+#include <string>
+
+using namespace collision_detector;
+
+namespace {
+
+constexpr double MAP_SIZE = 100.0;
+// Путь собаки за тик: скорость порядка 3 клеток в секунду при тике 50 мс
+constexpr double STEP = 0.15;
+
+struct Scene {
+    std::vector<Item> items;
+    std::vector<Gatherer> gatherers;
+};
+
+Scene MakeScene(size_t items_count, size_t gatherers_count) {
+    std::mt19937 rnd{3};
+    std::uniform_real_distribution<double> coord(0.0, MAP_SIZE);
+    Scene scene;
+    for (size_t i = 0; i < items_count; ++i) {
+        scene.items.push_back({{coord(rnd), coord(rnd)}, 0.0});
+    }
+    for (size_t i = 0; i < gatherers_count; ++i) {
+        geom::Point2D start{coord(rnd), coord(rnd)};
+        geom::Point2D end = start;
+        (i % 2 ? end.x : end.y) += STEP;
+        scene.gatherers.push_back({start, end, 0.6});
+    }
+    return scene;
+}
+
+}  // namespace
+
+// По этим замерам выбран GRID_MIN_ITEMS: и на 10, и на 1000 собирателях сетка обгоняет перебор примерно с 8 предметов
+TEST_CASE("Gather events: brute force vs grid", "[!benchmark]") {
+    std::vector<GatheringEvent> events;
+    GatherScratch scratch;
+    for (size_t gatherers_count : {10, 1'000}) {
+        for (size_t items_count : {1, 2, 4, 8, 16, 64, 256, 1024}) {
+            const auto scene = MakeScene(items_count, gatherers_count);
+            const auto name = std::to_string(gatherers_count) + " gatherers, " + std::to_string(items_count) + " items";
+            BENCHMARK("brute force: " + name) {
+                FindGatherEventsBruteForce(scene.items, scene.gatherers, events);
+                return events.size();
+            };
+            BENCHMARK("grid: " + name) {
+                FindGatherEventsWithGrid(scene.items, scene.gatherers, events, scratch);
+                return events.size();
+            };
+        }
+    }
+}
+
+namespace {
+
+// Предметы и собаки на сетке дорог с шагом 10: собаки идут вдоль своей дороги и отклоняются от оси не больше чем на 0.4
+Scene MakeRoadScene(size_t items_count, size_t gatherers_count) {
+    std::mt19937 rnd{5};
+    std::uniform_int_distribution<int> line(0, static_cast<int>(MAP_SIZE) / 10);
+    std::uniform_real_distribution<double> along(0.0, MAP_SIZE);
+    std::uniform_real_distribution<double> offset(-0.4, 0.4);
+    Scene scene;
+    for (size_t i = 0; i < items_count; ++i) {
+        const double l = line(rnd) * 10.0;
+        scene.items.push_back({i % 2 ? geom::Point2D{along(rnd), l} : geom::Point2D{l, along(rnd)}, 0.0});
+    }
+    for (size_t i = 0; i < gatherers_count; ++i) {
+        const double l = line(rnd) * 10.0 + offset(rnd);
+        const geom::Point2D start = i % 2 ? geom::Point2D{along(rnd), l} : geom::Point2D{l, along(rnd)};
+        geom::Point2D end = start;
+        (i % 2 ? end.x : end.y) += STEP;
+        scene.gatherers.push_back({start, end, 0.6});
+    }
+    return scene;
+}
+
+}  // namespace
+
+// Поиск по линиям дорог сопоставим с сеткой, но построение индекса с сортировкой внутри линий дороже
+// построения сетки подсчётом, поэтому по умолчанию остаётся сетка
+TEST_CASE("Gather events: grid vs road lines", "[!benchmark]") {
+    std::vector<GatheringEvent> events;
+    GatherScratch scratch;
+    for (size_t gatherers_count : {10, 1'000}) {
+        for (size_t items_count : {16, 256, 1024, 16'384}) {
+            const auto scene = MakeRoadScene(items_count, gatherers_count);
+            const auto name = std::to_string(gatherers_count) + " gatherers, " + std::to_string(items_count) + " items";
+            BENCHMARK("grid: " + name) {
+                FindGatherEventsWithGrid(scene.items, scene.gatherers, events, scratch);
+                return events.size();
+            };
+            BENCHMARK("road lines: " + name) {
+                FindGatherEventsOnRoadLines(scene.items, scene.gatherers, events, scratch);
+                return events.size();
+            };
+        }
+    }
+}
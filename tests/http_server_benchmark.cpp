@@ -0,0 +1,148 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/http_server.h"
+#include "../src/reactor_pool.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+namespace net = boost::asio;
+namespace http = boost::beast::http;
+using tcp = net::ip::tcp;
+
+namespace {
+
+constexpr size_t CONNECTIONS = 64;
+constexpr int REQUESTS_PER_CONNECTION = 50;
+constexpr std::array THREAD_COUNTS{1u, 2u, 4u, 8u, 16u, 32u, 64u};
+
+const std::string STATE_BODY = [] {
+    std::string body = R"({"players":{)";
+    for (int i = 0; i < 10; ++i) {
+        body += (i ? ","s : ""s) + R"(")" + std::to_string(i)
+              + R"(":{"pos":[10.25,4.5],"speed":[0.0,-3.0],"dir":"U","bag":[],"score":30})";
+    }
+    body += R"(},"lostObjects":{}})";
+    return body;
+}();
+
+// Как обработчик API: ответ собирается в общем strand игры, а отправляется из потока сессии
+struct GameStrandHandler {
+    template <typename Request, typename Endpoint, typename Send>
+    void operator()(Request&& req, const Endpoint&, Send&& send) const {
+        net::dispatch(game_strand, [version = req.version(), keep_alive = req.keep_alive(), send = std::forward<Send>(send)] {
+            http_server::StringResponse response{http::status::ok, version};
+            response.set(http::field::content_type, "application/json"sv);
+            response.keep_alive(keep_alive);
+            response.body() = STATE_BODY;
+            response.content_length(STATE_BODY.size());
+            send(std::move(response));
+        });
+    }
+
+    http_server::Strand game_strand;
+};
+
+// Держит CONNECTIONS keep-alive соединений и прогоняет по ним запросы из своих потоков
+class LoadGenerator {
+public:
+    explicit LoadGenerator(const tcp::endpoint& endpoint) {
+        for (size_t i = 0; i < CONNECTIONS; ++i) {
+            sockets_.emplace_back(ioc_).connect(endpoint);
+        }
+    }
+
+    void Run() {
+        std::vector<std::jthread> clients;
+        clients.reserve(sockets_.size());
+        for (auto& socket : sockets_) {
+            clients.emplace_back([&socket] {
+                http::request<http::empty_body> request{http::verb::get, "/api/v1/game/state", 11};
+                request.keep_alive(true);
+                boost::beast::flat_buffer buffer;
+                for (int i = 0; i < REQUESTS_PER_CONNECTION; ++i) {
+                    http::write(socket, request);
+                    http::response<http::string_body> response;
+                    http::read(socket, buffer, response);
+                }
+            });
+        }
+    }
+
+private:
+    net::io_context ioc_;
+    std::vector<tcp::socket> sockets_;
+};
+
+const tcp::endpoint LOOPBACK{net::ip::make_address("127.0.0.1"), 0};
+
+}  // namespace
+
+TEST_CASE("HTTP keep-alive throughput", "[!benchmark]") {
+    for (const auto threads : THREAD_COUNTS) {
+        const auto title = std::to_string(threads) + " threads, "s + std::to_string(CONNECTIONS * REQUESTS_PER_CONNECTION) + " requests"s;
+
+        // Общий io_context на все потоки (режим по умолчанию)
+        {
+            net::io_context game_ioc{1};
+            auto game_work = net::make_work_guard(game_ioc);
+            std::jthread game_thread{[&game_ioc] {
+                game_ioc.run();
+            }};
+
+            net::io_context ioc{static_cast<int>(threads)};
+            auto listener = std::make_shared<http_server::Listener<GameStrandHandler>>(
+                ioc, LOOPBACK, GameStrandHandler{net::make_strand(game_ioc)});
+            listener->Run();
+            std::vector<std::jthread> workers;
+            for (unsigned i = 0; i < threads; ++i) {
+                workers.emplace_back([&ioc] {
+                    ioc.run();
+                });
+            }
+
+            LoadGenerator load{listener->GetLocalEndpoint()};
+            BENCHMARK("shared io_context, " + title) {
+                load.Run();
+            };
+
+            ioc.stop();
+            game_ioc.stop();
+        }
+
+        // Независимые io_context с SO_REUSEPORT
+        {
+            net::io_context game_ioc{1};
+            auto game_work = net::make_work_guard(game_ioc);
+            std::jthread game_thread{[&game_ioc] {
+                game_ioc.run();
+            }};
+
+            util::ReactorPool reactors{threads};
+            const GameStrandHandler handler{net::make_strand(game_ioc)};
+            // Первый Listener выбирает свободный порт, остальные присоединяются к нему
+            auto first = std::make_shared<http_server::Listener<GameStrandHandler>>(reactors[0], LOOPBACK, handler, true);
+            first->Run();
+            const auto endpoint = first->GetLocalEndpoint();
+            for (size_t i = 1; i < reactors.Size(); ++i) {
+                std::make_shared<http_server::Listener<GameStrandHandler>>(reactors[i], endpoint, handler, true)->Run();
+            }
+            std::jthread reactor_threads{[&reactors] {
+                reactors.Run(false);
+            }};
+
+            LoadGenerator load{endpoint};
+            BENCHMARK("SO_REUSEPORT reactors, " + title) {
+                load.Run();
+            };
+
+            reactors.Stop();
+            game_ioc.stop();
+        }
+    }
+}
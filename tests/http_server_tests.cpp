@@ -0,0 +1,183 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/http_server.h"
+#include "../src/request_handler.h"
+#include "../src/websocket_session.h"
+#include "allocation_counter.h"
+#include "test_config.h"
+
+#include <boost/log/core.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+namespace net = boost::asio;
+namespace http = boost::beast::http;
+namespace websocket = boost::beast::websocket;
+using tcp = net::ip::tcp;
+
+namespace {
+
+constexpr int WARMUP_REQUESTS = 100;
+constexpr int MEASURED_REQUESTS = 1'000;
+
+struct Subscribers {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<http_server::WebSocketSession>> connections;
+};
+
+// Принимает переход на WebSocket. На каждое сообщение клиента рассылает всем подключённым один общий кадр
+struct BroadcastHandler {
+    template <typename Request, typename Endpoint, typename Send>
+    void operator()(Request&&, const Endpoint&, Send&&) const {
+    }
+
+    void operator()(http_server::StringRequest&& req, http_server::Socket&& socket) const {
+        auto connection = std::make_shared<http_server::WebSocketSession>(std::move(socket));
+        {
+            std::lock_guard lock{subscribers->mutex};
+            subscribers->connections.push_back(connection);
+        }
+        connection->Accept(std::move(req), [subscribers = subscribers](std::string message) {
+            const auto frame = std::make_shared<const std::string>("state after " + message);
+            std::lock_guard lock{subscribers->mutex};
+            for (const auto& subscriber : subscribers->connections) {
+                subscriber->Push(frame);
+            }
+        });
+    }
+
+    std::shared_ptr<Subscribers> subscribers;
+};
+
+}  // namespace
+
+SCENARIO("Keep-alive HTTP session") {
+    GIVEN("the game server stack on one thread, with a joined player") {
+        // Записи журнала в тесте не нужны. Поток журнала собирает их json по-прежнему, но не пишет в консоль.
+        // Он не входит в замер: форматирование записей для Boost.Log - его работа, и ответ его не ждёт
+        boost::log::core::get()->set_logging_enabled(false);
+        logging::AccessLog access_log;
+        app::Application application{test_util::TempGameConfig{}.GetPath(), false,
+            std::unique_ptr<db::Database, void(*)(db::Database*)>{nullptr, [](db::Database*) {}}};
+        const auto token = *application.JoinGame(model::Map::Id{"map1"s}, "dog"sv).second;
+
+        // Как в main при одном потоке: сессии и strand игры работают в одном io_context
+        net::io_context ioc;
+        auto handler = std::make_shared<http_handler::RequestHandler>(application, std::filesystem::temp_directory_path(),
+                                                                      net::make_strand(ioc), false);
+        http_handler::LoggingRequestHandler logging_handler{
+            [handler](auto&& req, auto&& send) {
+                (*handler)(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
+            }, access_log};
+        auto listener = std::make_shared<http_server::Listener<decltype(logging_handler)>>(
+            ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}, std::move(logging_handler));
+        listener->Run();
+        std::thread server{[&ioc] {
+            ioc.run();
+        }};
+
+        // Выделения в потоке сервера, то есть в сессии, в обработчике API и в журнале запросов.
+        // Замер снимает задание в очереди сервера, сам он памяти не выделяет
+        auto server_allocations = [&ioc] {
+            constexpr auto NOT_READY = std::numeric_limits<std::size_t>::max();
+            std::atomic<std::size_t> count{NOT_READY};
+            net::post(ioc, [&count] {
+                count.store(test_util::GetThreadAllocationCount());
+                count.notify_one();
+            });
+            count.wait(NOT_READY);
+            return count.load();
+        };
+
+        net::io_context client_ioc;
+        tcp::socket socket{client_ioc};
+        socket.connect(listener->GetLocalEndpoint());
+        boost::beast::flat_buffer buffer;
+
+        http::request<http::empty_body> request{http::verb::get, "/api/v1/game/state", 11};
+        request.set(http::field::host, "127.0.0.1"sv);
+        request.set(http::field::authorization, "Bearer "s + token);
+        request.keep_alive(true);
+
+        auto round_trip = [&] {
+            http::write(socket, request);
+            http::response<http::string_body> response;
+            http::read(socket, buffer, response);
+            return response;
+        };
+
+        WHEN("the connection has served a few state requests") {
+            for (int i = 0; i < WARMUP_REQUESTS; ++i) {
+                const auto response = round_trip();
+                REQUIRE(response.result() == http::status::ok);
+                REQUIRE(response.body().find(R"("players")"sv) != std::string::npos);
+            }
+            const auto before = server_allocations();
+            for (int i = 0; i < MEASURED_REQUESTS; ++i) {
+                round_trip();
+            }
+            const auto after = server_allocations();
+
+            THEN("parsing, answering and logging the requests does not touch the heap") {
+                CHECK(after - before == 0);
+            }
+        }
+
+        socket.close();
+        ioc.stop();
+        server.join();
+        boost::log::core::get()->set_logging_enabled(true);
+    }
+}
+
+SCENARIO("WebSocket push channel") {
+    GIVEN("a server that takes over WebSocket upgrade requests") {
+        auto subscribers = std::make_shared<Subscribers>();
+        net::io_context ioc;
+        auto listener = std::make_shared<http_server::Listener<BroadcastHandler>>(
+            ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}, BroadcastHandler{subscribers});
+        listener->Run();
+        std::thread server{[&ioc] {
+            ioc.run();
+        }};
+
+        net::io_context client_ioc;
+        auto connect = [&] {
+            auto ws = std::make_unique<websocket::stream<tcp::socket>>(client_ioc);
+            ws->next_layer().connect(listener->GetLocalEndpoint());
+            ws->handshake("127.0.0.1", "/api/v1/game/ws");
+            return ws;
+        };
+        auto read = [](websocket::stream<tcp::socket>& ws) {
+            boost::beast::flat_buffer buffer;
+            ws.read(buffer);
+            return boost::beast::buffers_to_string(buffer.data());
+        };
+
+        WHEN("two clients are subscribed and one of them sends a message") {
+            auto first = connect();
+            auto second = connect();
+            first->write(net::buffer("tick 1"sv));
+
+            THEN("both receive the same pushed frame") {
+                CHECK(read(*first) == "state after tick 1"s);
+                CHECK(read(*second) == "state after tick 1"s);
+            }
+
+            first->close(websocket::close_code::normal);
+            second->close(websocket::close_code::normal);
+        }
+
+        ioc.stop();
+        server.join();
+        // Обработчики сообщений держат список подписчиков, а он - соединения
+        subscribers->connections.clear();
+    }
+}
@@ -0,0 +1,58 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/json_loader.h"
+#include "test_config.h"
+
+using namespace std::literals;
+using test_util::DEFAULT_MAP;
+using test_util::TempGameConfig;
+
+SCENARIO("Game config loading") {
+    GIVEN("a config with a player limit per session") {
+        const TempGameConfig config{DEFAULT_MAP, R"("maxPlayersPerSession": 4)"};
+
+        THEN("the limit is applied to the game") {
+            CHECK(json_loader::LoadGame(config.GetPath()).GetMaxPlayersPerSession() == 4);
+        }
+    }
+
+    GIVEN("a config without a player limit") {
+        const TempGameConfig config;
+
+        THEN("sessions are unlimited") {
+            CHECK(json_loader::LoadGame(config.GetPath()).GetMaxPlayersPerSession() == 0);
+        }
+    }
+
+    GIVEN("a config with a negative player limit") {
+        const TempGameConfig config{DEFAULT_MAP, R"("maxPlayersPerSession": -1)"};
+
+        THEN("loading fails instead of wrapping the limit") {
+            CHECK_THROWS_AS(json_loader::LoadGame(config.GetPath()), std::runtime_error);
+        }
+    }
+
+    GIVEN("a config with an empty session lifetime in whole seconds") {
+        const TempGameConfig config{DEFAULT_MAP, R"("emptySessionLifetime": 5)"};
+
+        THEN("the lifetime is read as a number of seconds") {
+            CHECK(json_loader::LoadGame(config.GetPath()).GetEmptySessionLifetime() == 5s);
+        }
+    }
+
+    GIVEN("a config with a fractional empty session lifetime") {
+        const TempGameConfig config{DEFAULT_MAP, R"("emptySessionLifetime": 1.5)"};
+
+        THEN("the lifetime keeps milliseconds") {
+            CHECK(json_loader::LoadGame(config.GetPath()).GetEmptySessionLifetime() == 1500ms);
+        }
+    }
+
+    GIVEN("a config with a negative empty session lifetime") {
+        const TempGameConfig config{DEFAULT_MAP, R"("emptySessionLifetime": -0.5)"};
+
+        THEN("loading fails") {
+            CHECK_THROWS_AS(json_loader::LoadGame(config.GetPath()), std::runtime_error);
+        }
+    }
+}
@@ -0,0 +1,255 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model.h"
+
+#include <random>
+
+using namespace model;
+using namespace std::literals;
+
+namespace {
+
+// Прежняя реализация Map::MoveDog, перемещающая собаку по одной клетке.
+// Служит эталоном для сравнения с перемещением по участкам RoadGraph
+void ReferenceMoveDog(const Map& map, Dog* dog, std::chrono::milliseconds delta_ms) {
+    static constexpr double allowance = 0.4;
+    static constexpr double eps = 1e-6;
+    static constexpr double millis_per_second = 1000.0;
+
+    const auto& road_grid = map.GetRoadGrid();
+
+    auto dt = delta_ms.count() / millis_per_second;
+    auto currentPos = dog->GetPos();
+    auto velocity = dog->GetVelocity();
+
+    auto cell_x = static_cast<geom::Coord>(std::round(currentPos.x));
+    auto cell_y = static_cast<geom::Coord>(std::round(currentPos.y));
+
+    const auto is_on_vertical = road_grid.ContainsRoad({cell_x, cell_y + 1}) || road_grid.ContainsRoad({cell_x, cell_y - 1});
+    const auto is_on_horizontal = road_grid.ContainsRoad({cell_x + 1, cell_y}) || road_grid.ContainsRoad({cell_x - 1, cell_y});
+
+    const auto y_offset_out_of_range = std::abs(currentPos.y - cell_y) > allowance + eps;
+    const auto x_offset_out_of_range = std::abs(currentPos.x - cell_x) > allowance + eps;
+
+    auto move_axis = [&road_grid, dog, dt](double& pos, double vel, geom::Coord& cell, bool is_on_axis, bool offset_out_of_range, geom::Coord fixed_coord, bool is_x_axis) {
+        if (vel) {
+            double d = vel * dt;
+            auto target = pos + d;
+            auto target_cell = static_cast<geom::Coord>(std::round(target));
+            const geom::Coord step = (d > 0.0) ? 1 : -1;
+
+            const auto cant_move_along_axis = offset_out_of_range && is_on_axis;
+
+            if (!cant_move_along_axis) {
+                while (cell != target_cell) {
+                    if (road_grid.ContainsRoad({is_x_axis ? cell + step : fixed_coord, is_x_axis ? fixed_coord : cell + step})) {
+                        cell += step;
+                    } else {
+                        break;
+                    }
+                }
+            }
+
+            double curr = cell;
+            auto diff = target - curr;
+            const geom::Coord diff_step = (diff > 0.0) ? 1 : -1;
+
+            const auto is_road_ahead = road_grid.ContainsRoad({is_x_axis ? cell + diff_step : fixed_coord, is_x_axis ? fixed_coord : cell + diff_step});
+
+            if (step == diff_step && (cant_move_along_axis || !is_road_ahead) && std::abs(diff) > allowance) {
+                dog->SetIdle(true);
+                dog->SetVelocity({0, 0});
+                diff = std::clamp(diff, -allowance, allowance);
+            }
+
+            pos = curr + diff;
+        }
+    };
+
+    move_axis(currentPos.x, velocity.x, cell_x, is_on_vertical, y_offset_out_of_range, cell_y, true);
+    move_axis(currentPos.y, velocity.y, cell_y, is_on_horizontal, x_offset_out_of_range, cell_x, false);
+    dog->SetPos(currentPos);
+}
+
+Map MakeRandomMap(std::mt19937& rnd) {
+    Map map{Map::Id{"random"s}, "Random"s, 1.0, ExtraData{{}}, 3};
+    std::uniform_int_distribution<int> coord(-12, 12);
+    std::uniform_int_distribution<int> road_count(1, 12);
+    std::bernoulli_distribution horizontal;
+
+    for (int i = road_count(rnd); i > 0; --i) {
+        const geom::Point start{coord(rnd), coord(rnd)};
+        if (horizontal(rnd)) {
+            map.AddRoad(Road{Road::HORIZONTAL, start, coord(rnd)});
+        } else {
+            map.AddRoad(Road{Road::VERTICAL, start, coord(rnd)});
+        }
+    }
+    map.BuildRoadGraph();
+    return map;
+}
+
+geom::Point2D RandomPointOnRoad(const Map& map, std::mt19937& rnd) {
+    std::uniform_int_distribution<size_t> road_idx(0, map.GetRoads().size() - 1);
+    std::uniform_real_distribution<double> offset(-0.4, 0.4);
+    std::bernoulli_distribution exact;
+
+    const auto& road = map.GetRoads()[road_idx(rnd)];
+    std::uniform_real_distribution<double> x_dist(std::min(road.GetStart().x, road.GetEnd().x), std::max(road.GetStart().x, road.GetEnd().x));
+    std::uniform_real_distribution<double> y_dist(std::min(road.GetStart().y, road.GetEnd().y), std::max(road.GetStart().y, road.GetEnd().y));
+
+    geom::Point2D pos{x_dist(rnd), y_dist(rnd)};
+    // Собака может стоять у края дороги, в том числе в пределах допуска 0.4
+    if (!exact(rnd)) {
+        (road.IsHorizontal() ? pos.y : pos.x) += offset(rnd);
+    }
+    return pos;
+}
+
+}  // namespace
+
+SCENARIO("Segment based movement matches cell-by-cell movement") {
+    std::mt19937 rnd{20240101};
+    std::uniform_int_distribution<int> dir_dist(0, 3);
+    std::uniform_real_distribution<double> speed_dist(0.5, 30.0);
+    const std::array<std::chrono::milliseconds, 6> deltas{0ms, 1ms, 17ms, 100ms, 1000ms, 60000ms};
+
+    for (int map_idx = 0; map_idx < 300; ++map_idx) {
+        const auto map = MakeRandomMap(rnd);
+
+        for (int dog_idx = 0; dog_idx < 30; ++dog_idx) {
+            const auto pos = RandomPointOnRoad(map, rnd);
+            const auto speed = speed_dist(rnd);
+            const std::array<geom::Vec2D, 4> velocities{geom::Vec2D{0, -speed}, geom::Vec2D{0, speed}, geom::Vec2D{-speed, 0}, geom::Vec2D{speed, 0}};
+
+            Dog expected{"expected"sv, pos, velocities[dir_dist(rnd)], 3, 0};
+            expected.SetIdle(false);
+            Dog actual = expected;
+
+            // Собака идёт несколько тиков подряд, в том числе упираясь в конец дороги
+            for (int tick = 0; tick < 8; ++tick) {
+                const auto dt = deltas[std::uniform_int_distribution<size_t>(0, deltas.size() - 1)(rnd)];
+                ReferenceMoveDog(map, &expected, dt);
+                map.MoveDog(&actual, dt);
+
+                INFO("map: " << map_idx << ", dog: " << dog_idx << ", tick: " << tick);
+                REQUIRE(actual.GetPos() == expected.GetPos());
+                REQUIRE(actual.GetVelocity() == expected.GetVelocity());
+                REQUIRE(actual.IsIdle() == expected.IsIdle());
+
+                if (expected.GetVelocity() == geom::Vec2D{}) {
+                    const auto v = velocities[dir_dist(rnd)];
+                    expected.SetVelocity(v);
+                    actual.SetVelocity(v);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Kinetic trajectories match step-by-step movement") {
+    std::mt19937 rnd{20240202};
+    std::uniform_int_distribution<int> dir_dist(0, 3);
+    std::uniform_real_distribution<double> speed_dist(0.5, 30.0);
+    constexpr auto TICK = 10ms;
+
+    for (int map_idx = 0; map_idx < 300; ++map_idx) {
+        const auto map = MakeRandomMap(rnd);
+
+        for (int dog_idx = 0; dog_idx < 30; ++dog_idx) {
+            const auto pos = RandomPointOnRoad(map, rnd);
+            const auto speed = speed_dist(rnd);
+            const std::array<geom::Vec2D, 4> velocities{geom::Vec2D{0, -speed}, geom::Vec2D{0, speed}, geom::Vec2D{-speed, 0}, geom::Vec2D{speed, 0}};
+
+            Dog dog{"dog"sv, pos, velocities[dir_dist(rnd)], 3, 0};
+            dog.SetIdle(false);
+            auto stepped_pos = dog.GetPos();
+            auto stepped_vel = dog.GetVelocity();
+
+            DogTable dogs;
+            const auto slot = dogs.Add(dog);
+            const auto stop = map.FindStop(dog.GetPos(), dog.GetVelocity());
+            dogs.SetTrajectory(slot, stop.pos, stop.after);
+
+            // Пошаговая собака останавливается в тот же тик, что и кинетическая
+            std::vector<DogTable::Slot> stopped;
+            for (int tick = 0; stopped.empty(); ++tick) {
+                INFO("map: " << map_idx << ", dog: " << dog_idx << ", tick: " << tick);
+                REQUIRE(tick < 100'000);
+
+                const bool stepped_stop = map.MoveDog(stepped_pos, stepped_vel, TICK);
+                dogs.AdvanceTime(TICK);
+                dogs.CollectStops(stopped);
+
+                REQUIRE(stopped.empty() != stepped_stop);
+                const auto kinetic_pos = dogs.GetPos(slot);
+                CHECK(std::abs(kinetic_pos.x - stepped_pos.x) < 1e-9);
+                CHECK(std::abs(kinetic_pos.y - stepped_pos.y) < 1e-9);
+            }
+            CHECK(dogs.GetPos(slot) == stepped_pos);
+            CHECK(dogs.GetVelocities()[slot] == geom::Vec2D{});
+            CHECK_FALSE(dogs.HasTrajectory(slot));
+        }
+    }
+}
+
+SCENARIO("Fixed-point cells") {
+    GIVEN("coordinates around cell boundaries") {
+        THEN("they fall into the same cell as with std::round") {
+            for (const double x : {-2.5, -1.5, -1.25, -0.5, -0.25, 0.0, 0.25, 0.5, 1.25, 1.5, 2.5}) {
+                INFO("x: " << x);
+                CHECK(geom::FixedToCell(geom::ToFixed(x)) == static_cast<geom::Coord>(std::round(x)));
+            }
+            CHECK(geom::FixedToCell(geom::ToFixed(-0.5)) == -1);
+            CHECK(geom::FixedToCell(geom::ToFixed(0.5)) == 1);
+        }
+    }
+}
+
+SCENARIO("Fixed-point movement does not depend on tick splitting") {
+    std::mt19937 rnd{20240303};
+    std::uniform_int_distribution<int> dir_dist(0, 3);
+    std::uniform_real_distribution<double> speed_dist(0.5, 30.0);
+    std::uniform_int_distribution<int> total_dist(0, 5000);
+
+    for (int map_idx = 0; map_idx < 300; ++map_idx) {
+        const auto map = MakeRandomMap(rnd);
+
+        for (int dog_idx = 0; dog_idx < 30; ++dog_idx) {
+            const auto start = geom::ToFixed(RandomPointOnRoad(map, rnd));
+            const auto speed = speed_dist(rnd);
+            const std::array<geom::Vec2D, 4> velocities{geom::Vec2D{0, -speed}, geom::Vec2D{0, speed}, geom::Vec2D{-speed, 0}, geom::Vec2D{speed, 0}};
+            const auto start_vel = geom::ToFixed(velocities[dir_dist(rnd)]);
+            const std::chrono::milliseconds total{total_dist(rnd)};
+
+            auto whole_pos = start;
+            auto whole_vel = start_vel;
+            int64_t whole_remainder = 0;
+            const bool whole_stopped = map.MoveDog(whole_pos, whole_vel, total, whole_remainder);
+
+            // То же время, разбитое на случайные тики
+            auto split_pos = start;
+            auto split_vel = start_vel;
+            int64_t split_remainder = 0;
+            bool split_stopped = false;
+            for (auto left = total; left > 0ms;) {
+                const std::chrono::milliseconds dt{std::uniform_int_distribution<int64_t>(1, left.count())(rnd)};
+                split_stopped |= map.MoveDog(split_pos, split_vel, dt, split_remainder);
+                left -= dt;
+            }
+
+            INFO("map: " << map_idx << ", dog: " << dog_idx << ", total: " << total.count());
+            CHECK(split_pos == whole_pos);
+            CHECK(split_vel == whole_vel);
+            CHECK(split_stopped == whole_stopped);
+
+            // Путь в фиксированной точке отличается от пути в double не больше чем на шаг сетки
+            auto double_pos = geom::FromFixed(start);
+            geom::Vec2D double_vel{geom::FromFixed(start_vel.x), geom::FromFixed(start_vel.y)};
+            if (map.MoveDog(double_pos, double_vel, total) == whole_stopped) {
+                CHECK(std::abs(double_pos.x - geom::FromFixed(whole_pos.x)) <= 1.0 / geom::FIXED_ONE);
+                CHECK(std::abs(double_pos.y - geom::FromFixed(whole_pos.y)) <= 1.0 / geom::FIXED_ONE);
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/app.h"
+
+#include <boost/json.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+using namespace std::literals;
+namespace json = boost::json;
+
+namespace {
+
+constexpr size_t MAP_COUNT = 64;
+constexpr size_t DOGS_PER_MAP = 500;
+constexpr size_t LARGE_SESSION_DOGS = 20'000;
+constexpr auto TICK = 20ms;
+
+// Конфиг с MAP_COUNT копиями первой карты из GAME_CONFIG_FILE
+std::filesystem::path MakeManyMapsConfig() {
+    std::ifstream in{GAME_CONFIG_FILE};
+    std::string text{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    auto config = json::parse(text).as_object();
+
+    // собаки в бенчмарке не должны уходить на пенсию
+    config["dogRetirementTime"] = 1e9;
+
+    const auto prototype = config.at("maps").as_array().at(0).as_object();
+    json::array maps;
+    for (size_t i = 0; i < MAP_COUNT; ++i) {
+        auto map = prototype;
+        map["id"] = "map" + std::to_string(i);
+        maps.emplace_back(std::move(map));
+    }
+    config["maps"] = std::move(maps);
+
+    auto path = std::filesystem::temp_directory_path() / "parallel_tick_benchmark_config.json";
+    std::ofstream{path} << json::serialize(config);
+    return path;
+}
+
+std::unique_ptr<app::Application> MakeApplication(size_t map_count, size_t dogs_per_map) {
+    auto application = std::make_unique<app::Application>(MakeManyMapsConfig(), true,
+        std::unique_ptr<db::Database, void(*)(db::Database*)>{nullptr, [](db::Database*) {}});
+
+    std::mt19937 rnd{42};
+    const std::array actions{"L"sv, "R"sv, "U"sv, "D"sv};
+    for (size_t i = 0; i < map_count; ++i) {
+        const auto map_id = model::Map::Id{"map" + std::to_string(i)};
+        for (size_t j = 0; j < dogs_per_map; ++j) {
+            auto [player, token] = application->JoinGame(map_id, "dog"sv);
+            app::Application::SetPlayerAction(player.get(), actions[rnd() % actions.size()]);
+        }
+    }
+    return application;
+}
+
+}  // namespace
+
+TEST_CASE("Tick of many sessions", "[!benchmark]") {
+    auto application = MakeApplication(MAP_COUNT, DOGS_PER_MAP);
+    const auto hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    application->SetTickThreads(0);
+    BENCHMARK("serial tick") {
+        application->Tick(TICK);
+    };
+
+    application->SetTickThreads(hardware_threads - 1);
+    BENCHMARK("parallel tick, hardware_concurrency threads") {
+        application->Tick(TICK);
+    };
+}
+
+TEST_CASE("Tick of one large session", "[!benchmark]") {
+    auto application = MakeApplication(1, LARGE_SESSION_DOGS);
+    const auto hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    BENCHMARK("serial tick") {
+        application->Tick(TICK);
+    };
+
+    application->SetTickThreads(hardware_threads - 1);
+    application->SetParallelSessionThreshold(1);
+    BENCHMARK("parallel movement and gathering, hardware_concurrency threads") {
+        application->Tick(TICK);
+    };
+}
+
+TEST_CASE("Short ticks of one large session: stepped vs kinetic movement", "[!benchmark]") {
+    constexpr auto SHORT_TICK = 1ms;
+
+    auto stepped = MakeApplication(1, LARGE_SESSION_DOGS);
+    BENCHMARK("stepped movement, 1 ms tick") {
+        stepped->Tick(SHORT_TICK);
+    };
+
+    auto kinetic = MakeApplication(1, LARGE_SESSION_DOGS);
+    kinetic->SetKineticMovement(true);
+    BENCHMARK("kinetic movement, 1 ms tick") {
+        kinetic->Tick(SHORT_TICK);
+    };
+}
@@ -0,0 +1,96 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/recycling_allocator.h"
+#include "allocation_counter.h"
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+using util::ThreadMemoryPool;
+
+namespace {
+
+constexpr int ROUNDS = 20;
+constexpr size_t BLOCKS_PER_ROUND = 5'000;
+// Как запрос и ответ HTTP: заголовки небольшие, тело крупнее
+constexpr size_t SMALL_BLOCK = 200;
+constexpr size_t LARGE_BLOCK = 6'000;
+
+// Выделяет блоки в отдельном потоке, как поток сессии, разбирающий запросы
+std::vector<std::pair<void*, size_t>> AllocateInOtherThread() {
+    std::vector<std::pair<void*, size_t>> blocks;
+    std::jthread{[&blocks] {
+        for (size_t i = 0; i < BLOCKS_PER_ROUND; ++i) {
+            const auto size = i % 2 ? SMALL_BLOCK : LARGE_BLOCK;
+            blocks.emplace_back(ThreadMemoryPool::Allocate(size), size);
+        }
+    }};
+    return blocks;
+}
+
+// Выделяет и освобождает блок в деструкторе, который выполняется после уничтожения пула потока
+struct LateAllocationProbe {
+    ~LateAllocationProbe() {
+        const auto before = test_util::GetThreadAllocationCount();
+        auto* block = ThreadMemoryPool::Allocate(SMALL_BLOCK);
+        *from_heap = test_util::GetThreadAllocationCount() - before == 1;
+        ThreadMemoryPool::Deallocate(block, SMALL_BLOCK);
+        *retained = ThreadMemoryPool::GetRetainedBytes();
+    }
+
+    bool* from_heap = nullptr;
+    size_t* retained = nullptr;
+};
+
+}  // namespace
+
+SCENARIO("Thread memory pool") {
+    GIVEN("a thread") {
+        WHEN("it frees a block and allocates one of the same class") {
+            THEN("the block is reused") {
+                std::jthread{[] {
+                    auto* block = ThreadMemoryPool::Allocate(SMALL_BLOCK);
+                    ThreadMemoryPool::Deallocate(block, SMALL_BLOCK);
+                    CHECK(ThreadMemoryPool::GetRetainedBytes() > 0);
+                    CHECK(ThreadMemoryPool::Allocate(SMALL_BLOCK - 1) == block);
+                    CHECK(ThreadMemoryPool::GetRetainedBytes() == 0);
+                    ThreadMemoryPool::Deallocate(block, SMALL_BLOCK - 1);
+                }};
+            }
+        }
+
+        WHEN("it keeps freeing blocks allocated by other threads") {
+            THEN("the memory it retains stays bounded") {
+                std::jthread{[] {
+                    for (int round = 0; round < ROUNDS; ++round) {
+                        for (const auto& [block, size] : AllocateInOtherThread()) {
+                            ThreadMemoryPool::Deallocate(block, size);
+                        }
+                        // Блоки двух классов размера, каждый список ограничен отдельно
+                        INFO("round " << round);
+                        CHECK(ThreadMemoryPool::GetRetainedBytes() <= 2 * ThreadMemoryPool::MAX_FREE_BYTES_PER_CLASS);
+                    }
+                }};
+            }
+        }
+
+        WHEN("a thread_local destroyed after the pool allocates and frees a block") {
+            bool from_heap = false;
+            size_t retained = 1;
+            std::jthread{[&] {
+                // Создан раньше пула потока, поэтому уничтожается после него
+                thread_local LateAllocationProbe probe;
+                probe.from_heap = &from_heap;
+                probe.retained = &retained;
+                // Блок остаётся в списке пула до конца потока
+                ThreadMemoryPool::Deallocate(ThreadMemoryPool::Allocate(SMALL_BLOCK), SMALL_BLOCK);
+            }}.join();
+
+            THEN("it goes to the heap instead of the destroyed free lists") {
+                CHECK(from_heap);
+                CHECK(retained == 0);
+            }
+        }
+    }
+}
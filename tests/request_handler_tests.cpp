@@ -0,0 +1,262 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/request_handler.h"
+#include "test_config.h"
+
+#include <boost/asio/post.hpp>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <type_traits>
+
+using namespace std::literals;
+using http_handler::ETagMatches;
+using http_handler::ParseUrl;
+using http_handler::StringResponse;
+namespace net = boost::asio;
+namespace http = boost::beast::http;
+
+namespace {
+
+// Одна собака на сессию: каждый следующий игрок попадает в новую сессию
+constexpr std::string_view SETTINGS = R"("defaultDogSpeed": 3.0, "maxPlayersPerSession": 1)";
+
+// Обработчик запросов со своим io_context и игроком, присоединившимся к игре
+class RequestHandlerFixture {
+public:
+    explicit RequestHandlerFixture(std::chrono::milliseconds long_poll_timeout = http_handler::RequestHandler::DEFAULT_LONG_POLL_TIMEOUT)
+        : handler_{std::make_shared<http_handler::RequestHandler>(application_, std::filesystem::temp_directory_path(),
+                                                                   api_strand_, false, long_poll_timeout)} {
+        application_.AddListener(handler_);
+        token_ = *application_.JoinGame(model::Map::Id{"map1"s}, "dog"sv).second;
+        server_ = std::thread{[this] {
+            ioc_.run();
+        }};
+    }
+
+    ~RequestHandlerFixture() {
+        work_.reset();
+        ioc_.stop();
+        server_.join();
+    }
+
+    // Запрос состояния игры. Ответ придёт из strand игры, поэтому возвращается future
+    std::future<StringResponse> GetState(std::string_view target, std::string_view if_none_match = {}) {
+        return GetStateAs(token_, target, if_none_match);
+    }
+
+    std::future<StringResponse> GetStateAs(const std::string& token, std::string_view target, std::string_view if_none_match = {}) {
+        // Как и в HTTP-сессии, запрос живёт, пока не отправлен ответ
+        auto request = std::make_shared<http_handler::StringRequest>(http::verb::get, target, 11);
+        request->set(http::field::authorization, "Bearer "s + token);
+        if (!if_none_match.empty()) {
+            request->set(http::field::if_none_match, if_none_match);
+        }
+
+        auto response = std::make_shared<std::promise<StringResponse>>();
+        auto result = response->get_future();
+        (*handler_)(*request, [this, request, response](auto&& resp) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(resp)>, StringResponse>) {
+                ++response_count_;
+                response->set_value(std::move(resp));
+            }
+        });
+        return result;
+    }
+
+    // Токен нового игрока
+    std::string Join(std::string_view name) {
+        std::promise<std::string> token;
+        net::post(api_strand_, [&] {
+            token.set_value(*application_.JoinGame(model::Map::Id{"map1"s}, name).second);
+        });
+        return token.get_future().get();
+    }
+
+    // Возвращается, когда отправлены и ответы, отложенные до этого тика: они идут следующими заданиями strand
+    void Tick() {
+        std::promise<void> done;
+        net::post(api_strand_, [&] {
+            application_.Tick(10ms);
+            net::post(api_strand_, [&] {
+                done.set_value();
+            });
+        });
+        done.get_future().get();
+    }
+
+    int GetResponseCount() const {
+        return response_count_;
+    }
+
+private:
+    app::Application application_{test_util::TempGameConfig{test_util::DEFAULT_MAP, SETTINGS}.GetPath(), false,
+        std::unique_ptr<db::Database, void(*)(db::Database*)>{nullptr, [](db::Database*) {}}};
+    net::io_context ioc_;
+    net::executor_work_guard<net::io_context::executor_type> work_ = net::make_work_guard(ioc_);
+    http_handler::RequestHandler::Strand api_strand_ = net::make_strand(ioc_);
+    std::shared_ptr<http_handler::RequestHandler> handler_;
+    std::string token_;
+    std::atomic<int> response_count_{0};
+    std::thread server_;
+};
+
+// Версия состояния из сильного ETag вида "эпоха-сессия-версия"
+std::string VersionFromETag(const StringResponse& response) {
+    const std::string_view etag = response.at(http::field::etag);
+    const auto version_start = etag.rfind('-') + 1;
+    return std::string(etag.substr(version_start, etag.size() - version_start - 1));
+}
+
+}  // namespace
+
+SCENARIO("If-None-Match matching") {
+    GIVEN("the ETag of the current state") {
+        const auto etag = R"("7")"sv;
+
+        THEN("it is found in a single value or in a list") {
+            CHECK(ETagMatches(R"("7")"sv, etag));
+            CHECK(ETagMatches(R"("5", "7")"sv, etag));
+            CHECK(ETagMatches(R"("5","7" , "9")"sv, etag));
+        }
+        THEN("weak ETags are compared by value") {
+            CHECK(ETagMatches(R"(W/"7")"sv, etag));
+            CHECK(ETagMatches(R"("5", W/"7")"sv, etag));
+        }
+        THEN("the wildcard matches any ETag") {
+            CHECK(ETagMatches("*"sv, etag));
+        }
+        THEN("other ETags do not match") {
+            CHECK_FALSE(ETagMatches(R"("70")"sv, etag));
+            CHECK_FALSE(ETagMatches(R"("5", W/"8")"sv, etag));
+            CHECK_FALSE(ETagMatches("7"sv, etag));
+            CHECK_FALSE(ETagMatches(""sv, etag));
+        }
+    }
+}
+
+SCENARIO("URL parsing") {
+    WHEN("the URL has query parameters") {
+        const auto url = ParseUrl("/api/v1/game/records?start=10&maxItems=5&flag"sv);
+
+        THEN("the path loses its leading slash") {
+            CHECK(url.path == "api/v1/game/records"sv);
+        }
+        THEN("parameters are found by key, a key without '=' has an empty value") {
+            REQUIRE(url.parameters.size() == 3);
+            CHECK(url.parameters.find("start"sv)->second == "10"sv);
+            CHECK(url.parameters.find("maxItems"sv)->second == "5"sv);
+            CHECK(url.parameters.find("flag"sv)->second.empty());
+        }
+    }
+    WHEN("a value contains '='") {
+        const auto url = ParseUrl("/state?token=abc=def"sv);
+
+        THEN("the value ends at it") {
+            CHECK(url.parameters.find("token"sv)->second == "abc"sv);
+        }
+    }
+    THEN("an empty key is rejected") {
+        CHECK_THROWS_AS(ParseUrl("/state?a=1&&b=2"sv), http_handler::httpException);
+        CHECK_THROWS_AS(ParseUrl("/state?=1"sv), http_handler::httpException);
+    }
+}
+
+SCENARIO("Conditional and long-poll game state requests") {
+    GIVEN("a player in a game") {
+        RequestHandlerFixture fixture;
+        const auto state = fixture.GetState("/api/v1/game/state"sv).get();
+        REQUIRE(state.result() == http::status::ok);
+        const std::string etag{state.at(http::field::etag)};
+        const auto version = VersionFromETag(state);
+
+        THEN("the state varies by the player token") {
+            CHECK(state.at(http::field::vary) == "Authorization"sv);
+        }
+
+        WHEN("the client already has the current ETag") {
+            const auto response = fixture.GetState("/api/v1/game/state"sv, etag).get();
+
+            THEN("the server answers 304 without a body") {
+                CHECK(response.result() == http::status::not_modified);
+                CHECK(response.at(http::field::etag) == etag);
+                CHECK(response.at(http::field::vary) == "Authorization"sv);
+                CHECK(response.body().empty());
+            }
+        }
+
+        WHEN("a player of another session at the same version sends this ETag") {
+            const auto other_token = fixture.Join("other dog"sv);
+            const auto other_state = fixture.GetStateAs(other_token, "/api/v1/game/state"sv).get();
+            REQUIRE(VersionFromETag(other_state) == version);
+            const auto response = fixture.GetStateAs(other_token, "/api/v1/game/state"sv, etag).get();
+
+            THEN("the server sends the state of that session") {
+                CHECK(response.result() == http::status::ok);
+                CHECK(response.at(http::field::etag) != etag);
+            }
+        }
+
+        WHEN("the client has an outdated ETag") {
+            const auto response = fixture.GetState("/api/v1/game/state"sv, R"("100500")"sv).get();
+
+            THEN("the server sends the state") {
+                CHECK(response.result() == http::status::ok);
+                CHECK(response.at(http::field::etag) == etag);
+            }
+        }
+
+        WHEN("waitForTick is not a version") {
+            const auto response = fixture.GetState("/api/v1/game/state?waitForTick=abc"sv).get();
+
+            THEN("the server answers 400") {
+                CHECK(response.result() == http::status::bad_request);
+                CHECK(response.body().find("invalidArgument"sv) != std::string::npos);
+            }
+        }
+
+        WHEN("the client waits for the tick after the version it has") {
+            auto response = fixture.GetState("/api/v1/game/state?waitForTick="s + version);
+
+            THEN("the request is parked until the tick") {
+                CHECK(response.wait_for(100ms) == std::future_status::timeout);
+                fixture.Tick();
+                REQUIRE(response.wait_for(0s) == std::future_status::ready);
+                const auto released = response.get();
+                CHECK(released.result() == http::status::ok);
+                CHECK(VersionFromETag(released) != version);
+            }
+        }
+
+        WHEN("the client waits for a version it does not have") {
+            const auto response = fixture.GetState("/api/v1/game/state?waitForTick=100500"sv).get();
+
+            THEN("the server answers at once") {
+                CHECK(response.result() == http::status::ok);
+                CHECK(response.at(http::field::etag) == etag);
+            }
+        }
+    }
+
+    GIVEN("a short long-poll timeout") {
+        RequestHandlerFixture fixture{100ms};
+        const auto version = VersionFromETag(fixture.GetState("/api/v1/game/state"sv).get());
+
+        WHEN("no tick comes while a request is parked") {
+            auto response = fixture.GetState("/api/v1/game/state?waitForTick="s + version);
+
+            THEN("the request gets the current state at the deadline") {
+                REQUIRE(response.wait_for(5s) == std::future_status::ready);
+                const auto released = response.get();
+                CHECK(released.result() == http::status::ok);
+                CHECK(VersionFromETag(released) == version);
+
+                AND_THEN("the next tick does not answer it again") {
+                    fixture.Tick();
+                    CHECK(fixture.GetResponseCount() == 2);
+                }
+            }
+        }
+    }
+}
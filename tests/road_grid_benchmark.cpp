@@ -0,0 +1,124 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/json_loader.h"
+#include "../src/model.h"
+
+#include <random>
+#include <unordered_map>
+
+using namespace model;
+
+namespace {
+
+// Прежняя реализация RoadGrid, оставлена для сравнения
+class HashRoadGrid {
+public:
+    void AddRoad(const Road& road) {
+        for (auto x = std::min(road.GetStart().x, road.GetEnd().x); x <= std::max(road.GetStart().x, road.GetEnd().x); ++x) {
+            for (auto y = std::min(road.GetStart().y, road.GetEnd().y); y <= std::max(road.GetStart().y, road.GetEnd().y); ++y) {
+                grid_[{x, y}] = true;
+            }
+        }
+    }
+
+    bool ContainsRoad(const geom::Point& p) const {
+        return grid_.find(p) != grid_.end();
+    }
+
+private:
+    std::unordered_map<geom::Point, bool, geom::PointHasher> grid_;
+};
+
+struct Fixture {
+    RoadGrid bitmap;
+    HashRoadGrid hash;
+    std::vector<geom::Point> queries;
+
+    void AddRoad(const Road& road) {
+        bitmap.AddRoad(&road);
+        hash.AddRoad(road);
+    }
+
+    // Запросы вдоль дорог и вокруг них - так RoadGrid используется при перемещении собак
+    void MakeQueries(const std::vector<Road>& roads, size_t count) {
+        std::mt19937 rnd{42};
+        std::uniform_int_distribution<size_t> road_dist(0, roads.size() - 1);
+        std::uniform_int_distribution<int> offset_dist(-1, 1);
+        queries.reserve(count);
+        while (queries.size() < count) {
+            const auto& road = roads[road_dist(rnd)];
+            std::uniform_int_distribution<int> x_dist(std::min(road.GetStart().x, road.GetEnd().x), std::max(road.GetStart().x, road.GetEnd().x));
+            std::uniform_int_distribution<int> y_dist(std::min(road.GetStart().y, road.GetEnd().y), std::max(road.GetStart().y, road.GetEnd().y));
+            queries.push_back({x_dist(rnd) + offset_dist(rnd), y_dist(rnd) + offset_dist(rnd)});
+        }
+    }
+
+    template <typename Grid>
+    static size_t CountHits(const Grid& grid, const std::vector<geom::Point>& queries) {
+        size_t hits = 0;
+        for (const auto& p : queries) {
+            hits += grid.ContainsRoad(p);
+        }
+        return hits;
+    }
+
+    void Run(const std::string& name) {
+        REQUIRE(CountHits(bitmap, queries) == CountHits(hash, queries));
+        BENCHMARK("hash map: " + name) {
+            return CountHits(hash, queries);
+        };
+        BENCHMARK("bitmap: " + name) {
+            return CountHits(bitmap, queries);
+        };
+    }
+};
+
+std::vector<Road> MakeLattice(geom::Coord size, geom::Coord step) {
+    std::vector<Road> roads;
+    for (geom::Coord c = 0; c < size; c += step) {
+        roads.emplace_back(Road::HORIZONTAL, geom::Point{0, c}, size - 1);
+        roads.emplace_back(Road::VERTICAL, geom::Point{c, 0}, size - 1);
+    }
+    return roads;
+}
+
+constexpr size_t QUERY_COUNT = 1'000'000;
+
+}  // namespace
+
+TEST_CASE("RoadGrid lookup: maps from config", "[!benchmark]") {
+    const auto game = json_loader::LoadGame(GAME_CONFIG_FILE);
+    for (const auto& map : game.GetMaps()) {
+        Fixture fixture;
+        std::vector<Road> roads;
+        for (const auto& road : map.GetRoads()) {
+            roads.push_back(road);
+            fixture.AddRoad(road);
+        }
+        fixture.MakeQueries(roads, QUERY_COUNT);
+        fixture.Run(*map.GetId());
+    }
+}
+
+TEST_CASE("RoadGrid lookup: synthetic 10k x 10k maps", "[!benchmark]") {
+    SECTION("dense lattice") {
+        Fixture fixture;
+        const auto roads = MakeLattice(10'000, 100);
+        for (const auto& road : roads) {
+            fixture.AddRoad(road);
+        }
+        fixture.MakeQueries(roads, QUERY_COUNT);
+        fixture.Run("10k x 10k, road every 100 cells");
+    }
+
+    SECTION("sparse corridors") {
+        Fixture fixture;
+        const auto roads = MakeLattice(10'000, 2'500);
+        for (const auto& road : roads) {
+            fixture.AddRoad(road);
+        }
+        fixture.MakeQueries(roads, QUERY_COUNT);
+        fixture.Run("10k x 10k, road every 2500 cells");
+    }
+}
@@ -0,0 +1,55 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model.h"
+
+#include <random>
+#include <unordered_set>
+
+using namespace model;
+
+SCENARIO("Road grid") {
+    GIVEN("roads spanning several tiles, including negative coordinates") {
+        const std::vector<Road> roads{
+            {Road::HORIZONTAL, {-70, 0}, 130},
+            {Road::VERTICAL, {130, 0}, -200},
+            {Road::VERTICAL, {-70, 0}, 65},
+            {Road::HORIZONTAL, {-70, 65}, -140},
+            {Road::HORIZONTAL, {5, 5}, 5},
+        };
+
+        RoadGrid grid;
+        std::unordered_set<geom::Point, geom::PointHasher> reference;
+        for (const auto& road : roads) {
+            grid.AddRoad(&road);
+            const auto [x0, y0] = road.GetStart();
+            const auto [x1, y1] = road.GetEnd();
+            for (auto x = std::min(x0, x1); x <= std::max(x0, x1); ++x) {
+                for (auto y = std::min(y0, y1); y <= std::max(y0, y1); ++y) {
+                    reference.insert({x, y});
+                }
+            }
+        }
+
+        THEN("every cell is reported exactly like a per-cell lookup table") {
+            for (geom::Coord y = -260; y <= 260; ++y) {
+                for (geom::Coord x = -260; x <= 260; ++x) {
+                    INFO("x: " << x << ", y: " << y);
+                    REQUIRE(grid.ContainsRoad({x, y}) == reference.contains({x, y}));
+                }
+            }
+        }
+
+        THEN("extreme coordinates are outside the grid") {
+            CHECK_FALSE(grid.ContainsRoad({std::numeric_limits<geom::Coord>::max(), 0}));
+            CHECK_FALSE(grid.ContainsRoad({std::numeric_limits<geom::Coord>::min(), 0}));
+            CHECK_FALSE(grid.ContainsRoad({0, std::numeric_limits<geom::Coord>::min()}));
+        }
+    }
+
+    GIVEN("an empty grid") {
+        RoadGrid grid;
+        THEN("it contains no roads") {
+            CHECK_FALSE(grid.ContainsRoad({0, 0}));
+        }
+    }
+}
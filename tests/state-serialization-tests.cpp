@@ -5,6 +5,7 @@
 
 #include "../src/model.h"
 #include "../src/model_serialization.h"
+#include "test_config.h"
 
 using namespace model;
 using namespace std::literals;
@@ -18,6 +19,19 @@ struct Fixture {
     OutputArchive output_archive{strm};
 };
 
+constexpr std::string_view MAP = R"({
+    "id": "map1",
+    "name": "Map 1",
+    "lootTypes": [{"name": "key", "file": "assets/key.obj", "type": "obj", "value": 10}],
+    "roads": [{"x0": 0, "y0": 0, "x1": 40}],
+    "buildings": [],
+    "offices": []
+})";
+
+app::Application MakeApplication() {
+    return app::Application{test_util::TempGameConfig{MAP}.GetPath(), false, std::unique_ptr<db::Database, void(*)(db::Database*)>{nullptr, [](db::Database*) {}}};
+}
+
 }  // namespace
 
 SCENARIO_METHOD(Fixture, "Point serialization") {
@@ -85,3 +99,76 @@ SCENARIO_METHOD(Fixture, "Dog Serialization") {
         }
     }
 }
+
+SCENARIO_METHOD(Fixture, "Game session serialization") {
+    GIVEN("a session with dogs moving in fixed-point mode") {
+        auto application = MakeApplication();
+        application.SetFixedPointMovement(true);
+        application.JoinGame(Map::Id{"map1"s}, "Pluto"sv);
+        application.JoinGame(Map::Id{"map1"s}, "Goofy"sv);
+        for (const auto& [id, player] : application.GetPlayers().GetPlayers()) {
+            app::Application::SetPlayerAction(player.get(), "R"sv);
+        }
+        // 3 клетки в секунду за 7 мс - не целое число шагов сетки, остаток ненулевой
+        application.Tick(7ms);
+        const auto& session = *application.GetGame().GetSessions().at(Map::Id{"map1"s}).front();
+        const auto remainders = session.GetDogs().GetMoveRemainders();
+        REQUIRE(remainders[0] != 0);
+
+        WHEN("the session is serialized") {
+            {
+                serialization::GameSessionRepr repr{session};
+                output_archive << repr;
+            }
+
+            THEN("the movement remainders are restored") {
+                InputArchive input_archive{strm};
+                serialization::GameSessionRepr repr;
+                input_archive >> repr;
+                const auto restored = repr.Restore(application);
+
+                REQUIRE(restored.GetDogs().Size() == session.GetDogs().Size());
+                for (DogTable::Slot slot = 0; slot < session.GetDogs().Size(); ++slot) {
+                    CHECK(restored.GetDogs().GetId(slot) == session.GetDogs().GetId(slot));
+                    CHECK(restored.GetDogs().GetMoveRemainders()[slot] == remainders[slot]);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO_METHOD(Fixture, "Game serialization") {
+    GIVEN("a seeded game with two single-player sessions") {
+        constexpr uint64_t SEED = 42;
+        auto application = MakeApplication();
+        application.GetGame().SetRandomSeed(SEED);
+        application.GetGame().SetMaxPlayersPerSession(1);
+        application.JoinGame(Map::Id{"map1"s}, "Pluto"sv);
+        application.JoinGame(Map::Id{"map1"s}, "Goofy"sv);
+
+        WHEN("the game is restored and a new session is created") {
+            {
+                serialization::GameRepr repr{application.GetGame()};
+                output_archive << repr;
+            }
+            auto restored = MakeApplication();
+            restored.GetGame().SetRandomSeed(SEED);
+            restored.GetGame().SetMaxPlayersPerSession(1);
+            {
+                InputArchive input_archive{strm};
+                serialization::GameRepr repr;
+                input_archive >> repr;
+                repr.Restore(restored);
+            }
+            restored.JoinGame(Map::Id{"map1"s}, "Scooby"sv);
+
+            THEN("the new session does not reuse the random stream of a restored one") {
+                const auto& sessions = restored.GetGame().GetSessions().at(Map::Id{"map1"s});
+                REQUIRE(sessions.size() == 3);
+                CHECK(sessions[0]->GetRandom().GetSeed() == util::CounterRandom::DeriveSeed(SEED, 0));
+                CHECK(sessions[1]->GetRandom().GetSeed() == util::CounterRandom::DeriveSeed(SEED, 1));
+                CHECK(sessions[2]->GetRandom().GetSeed() == util::CounterRandom::DeriveSeed(SEED, 2));
+            }
+        }
+    }
+}
@@ -0,0 +1,206 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/state_publisher.h"
+#include "test_config.h"
+
+#include <boost/asio/post.hpp>
+#include <boost/json.hpp>
+
+#include <future>
+#include <thread>
+
+using namespace std::literals;
+namespace net = boost::asio;
+namespace http = boost::beast::http;
+namespace json = boost::json;
+namespace websocket = boost::beast::websocket;
+using tcp = net::ip::tcp;
+
+namespace {
+
+using WebSocket = websocket::stream<tcp::socket>;
+
+// Отдаёт запросы на переход к WebSocket издателю, как обработчик в main
+struct UpgradeHandler {
+    template <typename Request, typename Endpoint, typename Send>
+    void operator()(Request&&, const Endpoint&, Send&&) const {
+    }
+
+    void operator()(http_server::StringRequest&& req, http_server::Socket&& socket) const {
+        publisher->Subscribe(std::move(req), std::move(socket));
+    }
+
+    std::shared_ptr<http_handler::StatePublisher> publisher;
+};
+
+// Выполняет f в strand игры и дожидается результата
+template <typename Fn>
+auto RunOnStrand(const http_handler::StatePublisher::Strand& strand, Fn&& f) {
+    std::packaged_task<std::invoke_result_t<Fn>()> task{std::forward<Fn>(f)};
+    auto result = task.get_future();
+    net::post(strand, [&task] {
+        task();
+    });
+    return result.get();
+}
+
+std::string Read(WebSocket& ws) {
+    boost::beast::flat_buffer buffer;
+    ws.read(buffer);
+    return boost::beast::buffers_to_string(buffer.data());
+}
+
+}  // namespace
+
+SCENARIO("WebSocket state publisher") {
+    GIVEN("a server publishing game state to WebSocket subscribers") {
+        app::Application application{test_util::TempGameConfig{}.GetPath(), false,
+            std::unique_ptr<db::Database, void(*)(db::Database*)>{nullptr, [](db::Database*) {}}};
+        net::io_context ioc;
+        const auto api_strand = net::make_strand(ioc);
+        auto publisher = std::make_shared<http_handler::StatePublisher>(application, api_strand);
+        application.AddListener(publisher);
+
+        const auto& [player, token] = application.JoinGame(model::Map::Id{"map1"s}, "dog"sv);
+        const auto dog_id = player->GetDog().GetId();
+        const auto dog_key = std::to_string(dog_id);
+        const auto session = player->GetSession();
+
+        auto listener = std::make_shared<http_server::Listener<UpgradeHandler>>(
+            ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0}, UpgradeHandler{publisher});
+        listener->Run();
+        std::thread server{[&ioc] {
+            ioc.run();
+        }};
+
+        net::io_context client_ioc;
+        // Подключается по target. Заголовок Authorization добавляется, если задан bearer
+        auto subscribe = [&](std::string_view target, std::string bearer = {}) {
+            auto ws = std::make_unique<WebSocket>(client_ioc);
+            ws->next_layer().connect(listener->GetLocalEndpoint());
+            if (!bearer.empty()) {
+                ws->set_option(websocket::stream_base::decorator([bearer](websocket::request_type& req) {
+                    req.set(http::field::authorization, "Bearer "s + bearer);
+                }));
+            }
+            ws->handshake("127.0.0.1", target);
+            return ws;
+        };
+        // Запрос на переход к WebSocket обычным HTTP-запросом, чтобы прочитать ответ на отказ
+        auto upgrade_status = [&](std::string_view target, std::string_view bearer = {}) {
+            tcp::socket socket{client_ioc};
+            socket.connect(listener->GetLocalEndpoint());
+            http::request<http::empty_body> request{http::verb::get, target, 11};
+            request.set(http::field::host, "127.0.0.1"sv);
+            request.set(http::field::connection, "upgrade"sv);
+            request.set(http::field::upgrade, "websocket"sv);
+            request.set(http::field::sec_websocket_key, "dGhlIHNhbXBsZSBub25jZQ=="sv);
+            request.set(http::field::sec_websocket_version, "13"sv);
+            if (!bearer.empty()) {
+                request.set(http::field::authorization, "Bearer "s + std::string(bearer));
+            }
+            http::write(socket, request);
+            boost::beast::flat_buffer buffer;
+            http::response<http::string_body> response;
+            http::read(socket, buffer, response);
+            return response.result();
+        };
+        auto tick = [&] {
+            RunOnStrand(api_strand, [&] {
+                application.Tick(10ms);
+            });
+        };
+
+        WHEN("a client subscribes with the token parameter") {
+            auto ws = subscribe("/api/v1/game/ws?token="s + *token);
+
+            THEN("it receives the state of its session right away") {
+                const auto state = json::parse(Read(*ws));
+                CHECK(state.as_object().at("players").as_object().contains(dog_key));
+            }
+
+            AND_WHEN("it sends a move") {
+                Read(*ws);
+                ws->write(net::buffer(R"({"move": "R"})"sv));
+
+                THEN("the action is applied to its dog") {
+                    bool moving = false;
+                    for (int i = 0; i < 200 && !moving; ++i) {
+                        moving = RunOnStrand(api_strand, [&] {
+                            return player->GetDog().GetVelocity().x > 0;
+                        });
+                        if (!moving) {
+                            std::this_thread::sleep_for(10ms);
+                        }
+                    }
+                    CHECK(moving);
+                }
+            }
+
+            ws->close(websocket::close_code::normal);
+        }
+
+        WHEN("a client subscribes with the Authorization header") {
+            auto ws = subscribe("/api/v1/game/ws"sv, *token);
+
+            THEN("it is accepted") {
+                CHECK(json::parse(Read(*ws)).as_object().contains("players"));
+            }
+
+            ws->close(websocket::close_code::normal);
+        }
+
+        WHEN("a client subscribes without a valid token or to another path") {
+            THEN("the upgrade is rejected with an HTTP error") {
+                CHECK(upgrade_status("/api/v1/game/ws"sv) == http::status::unauthorized);
+                CHECK(upgrade_status("/api/v1/game/ws?token=0123456789abcdef0123456789abcdef"sv) == http::status::unauthorized);
+                CHECK(upgrade_status("/api/v1/game/ws"sv, "0123456789abcdef0123456789abcdef"sv) == http::status::unauthorized);
+                CHECK(upgrade_status("/api/v1/game/state?token="s + *token) == http::status::not_found);
+            }
+        }
+
+        WHEN("two players of the same session are subscribed and the game ticks") {
+            const auto [other_session, other_token] = RunOnStrand(api_strand, [&] {
+                const auto& [other, other_token] = application.JoinGame(model::Map::Id{"map1"s}, "other dog"sv);
+                return std::pair{other->GetSession(), other_token};
+            });
+            REQUIRE(other_session == session);
+            auto first = subscribe("/api/v1/game/ws?token="s + *token);
+            auto second = subscribe("/api/v1/game/ws?token="s + *other_token);
+            Read(*first);
+            Read(*second);
+            tick();
+
+            THEN("both receive the same frame with the whole session") {
+                const auto frame = Read(*first);
+                CHECK(Read(*second) == frame);
+                CHECK(json::parse(frame).as_object().at("players").as_object().size() == 2);
+            }
+
+            first->close(websocket::close_code::normal);
+            second->close(websocket::close_code::normal);
+        }
+
+        WHEN("the subscribed player retires") {
+            auto ws = subscribe("/api/v1/game/ws?token="s + *token);
+            Read(*ws);
+            // Как RetirementListener: игрок пропадает вместе с токеном и собакой
+            RunOnStrand(api_strand, [&] {
+                application.GetTokens().RemoveToken(dog_id);
+                application.GetPlayers().RemovePlayer(dog_id);
+                session->RemoveDog(dog_id);
+            });
+            tick();
+
+            THEN("the connection is closed") {
+                boost::beast::flat_buffer buffer;
+                boost::system::error_code ec;
+                ws->read(buffer, ec);
+                CHECK(ec == websocket::error::closed);
+            }
+        }
+
+        ioc.stop();
+        server.join();
+    }
+}
@@ -0,0 +1,37 @@
+#include "test_config.h"
+
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace test_util {
+
+namespace {
+
+// Имя уникально и между процессами: тестовые бинарники могут работать параллельно
+std::filesystem::path MakeUniquePath() {
+    static const auto process_tag = std::random_device{}();
+    static std::atomic<unsigned> counter{0};
+    return std::filesystem::temp_directory_path()
+         / ("game_config_" + std::to_string(process_tag) + "_" + std::to_string(counter++) + ".json");
+}
+
+}  // namespace
+
+TempGameConfig::TempGameConfig(std::string_view map, std::string_view settings)
+    : path_{MakeUniquePath()} {
+    std::ofstream out{path_};
+    out << '{';
+    if (!settings.empty()) {
+        out << settings << ',';
+    }
+    out << R"("lootGeneratorConfig": {"period": 5.0, "probability": 0.0}, "maps": [)" << map << "]}";
+}
+
+TempGameConfig::~TempGameConfig() {
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+}
+
+}  // namespace test_util
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+// Конфигурация игры для тестов во временном файле
+namespace test_util {
+
+// Карта map1 из двух дорог буквой Г, без зданий и офисов
+inline constexpr std::string_view DEFAULT_MAP = R"({
+    "id": "map1",
+    "name": "Map 1",
+    "lootTypes": [{"name": "key", "file": "assets/key.obj", "type": "obj", "value": 10}],
+    "roads": [{"x0": 0, "y0": 0, "x1": 40}, {"x0": 40, "y0": 0, "y1": 30}],
+    "buildings": [],
+    "offices": []
+})";
+
+inline constexpr std::string_view DEFAULT_SETTINGS = R"("defaultDogSpeed": 3.0)";
+
+// Файл конфигурации с одной картой. Трофеи не генерируются. У каждого объекта свой файл,
+// он удаляется в деструкторе: приложение читает конфигурацию только при создании
+class TempGameConfig {
+public:
+    // map - json-объект карты, settings - ключи верхнего уровня через запятую
+    explicit TempGameConfig(std::string_view map = DEFAULT_MAP, std::string_view settings = DEFAULT_SETTINGS);
+    ~TempGameConfig();
+
+    TempGameConfig(const TempGameConfig&) = delete;
+    TempGameConfig& operator=(const TempGameConfig&) = delete;
+
+    const std::filesystem::path& GetPath() const noexcept {
+        return path_;
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+}  // namespace test_util
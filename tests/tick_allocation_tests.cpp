@@ -0,0 +1,93 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/app.h"
+#include "allocation_counter.h"
+#include "test_config.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Несколько порций по PARALLEL_CHUNK_SIZE, чтобы параллельный тик действительно раздавал работу потокам
+constexpr size_t DOGS_COUNT = 2'500;
+constexpr auto TICK = 50ms;
+// Дольше, чем собака идёт от края до края дороги: устаревшие остановки кинетического режима успевают уйти из очереди
+constexpr int WARMUP_TICKS = 300;
+constexpr int MEASURED_TICKS = 100;
+
+// Одна дорога с офисом в начале и трофеями вдоль неё вне досягаемости собак: трофеи попадают в поиск столкновений,
+// но не подбираются, а новые не появляются, поэтому состояние сессии от тика к тику не растёт
+constexpr std::string_view MAP = R"({
+    "id": "map1",
+    "name": "Map 1",
+    "lootTypes": [{"name": "key", "file": "assets/key.obj", "type": "obj", "value": 10}],
+    "roads": [{"x0": 0, "y0": 0, "x1": 40}],
+    "buildings": [],
+    "offices": [{"id": "o0", "x": 0, "y": 0, "offsetX": 0, "offsetY": 0}]
+})";
+
+std::unique_ptr<app::Application> MakeApplication() {
+    const test_util::TempGameConfig config{MAP, R"("defaultDogSpeed": 4.0, "dogRetirementTime": 1000.0)"};
+    auto application = std::make_unique<app::Application>(config.GetPath(), false,
+        std::unique_ptr<db::Database, void(*)(db::Database*)>{nullptr, [](db::Database*) {}});
+    for (size_t i = 0; i < DOGS_COUNT; ++i) {
+        application->JoinGame(model::Map::Id{"map1"s}, "dog"sv);
+    }
+    auto& session = *application->GetGame().GetSessions().at(model::Map::Id{"map1"s}).front();
+    for (size_t i = 0; i < 16; ++i) {
+        session.AddLoot({0, {static_cast<double>(i), 1.0}}, i);
+    }
+    return application;
+}
+
+// Собаки ходят туда и обратно у офиса, не упираясь в край дороги
+void Tick(app::Application& application, int tick) {
+    for (const auto& [id, player] : application.GetPlayers().GetPlayers()) {
+        app::Application::SetPlayerAction(player.get(), tick % 2 ? "L"sv : "R"sv);
+    }
+    application.Tick(TICK);
+}
+
+}  // namespace
+
+SCENARIO("Steady-state tick does not allocate") {
+    GIVEN("a session of moving dogs after warmup") {
+        auto application = MakeApplication();
+
+        auto measure = [&] {
+            for (int tick = 0; tick < WARMUP_TICKS; ++tick) {
+                Tick(*application, tick);
+            }
+            const auto before = test_util::GetAllocationCount();
+            for (int tick = 0; tick < MEASURED_TICKS; ++tick) {
+                Tick(*application, tick);
+            }
+            return test_util::GetAllocationCount() - before;
+        };
+
+        THEN("stepped movement reuses tick buffers") {
+            CHECK(measure() == 0);
+        }
+
+        THEN("fixed-point movement reuses tick buffers") {
+            application->SetFixedPointMovement(true);
+            CHECK(measure() == 0);
+        }
+
+        THEN("kinetic movement reuses tick buffers") {
+            application->SetKineticMovement(true);
+            CHECK(measure() == 0);
+        }
+
+        THEN("parallel movement and gathering do not allocate on the worker pool") {
+            application->SetTickThreads(2);
+            application->SetParallelSessionThreshold(1);
+            CHECK(measure() == 0);
+        }
+
+        THEN("the road-line index reuses its buffers") {
+            application->SetGatherMode(collision_detector::GatherMode::ROAD_LINES);
+            CHECK(measure() == 0);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/worker_pool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+SCENARIO("Worker pool") {
+    for (unsigned threads : {0u, 1u, 4u}) {
+        GIVEN("a pool with " + std::to_string(threads) + " extra threads") {
+            util::WorkerPool pool{threads};
+
+            THEN("every index is processed exactly once") {
+                for (size_t n : {0, 1, 2, 7, 1000}) {
+                    std::vector<std::atomic<int>> hits(n);
+                    pool.ParallelFor(n, [&hits](size_t i) {
+                        ++hits[i];
+                    });
+                    for (const auto& h : hits) {
+                        REQUIRE(h == 1);
+                    }
+                }
+            }
+
+            THEN("an exception is rethrown after all other indices are processed") {
+                std::atomic<size_t> processed{0};
+                CHECK_THROWS_AS(pool.ParallelFor(100, [&processed](size_t i) {
+                    if (i == 42) {
+                        throw std::runtime_error("boom");
+                    }
+                    ++processed;
+                }), std::runtime_error);
+                CHECK(processed == 99);
+            }
+
+            THEN("nested calls complete") {
+                std::atomic<size_t> total{0};
+                pool.ParallelFor(8, [&pool, &total](size_t) {
+                    pool.ParallelFor(8, [&total](size_t) {
+                        ++total;
+                    });
+                });
+                CHECK(total == 64);
+            }
+        }
+    }
+}